@@ -0,0 +1,251 @@
+// Copyright 2021 Touca, Inc. Subject to Apache-2.0 License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "touca/core/key.hpp"
+#include "touca/core/testcase.hpp"
+#include "touca/lib_api.hpp"
+
+namespace touca {
+namespace detail {
+
+/**
+ * @brief Results captured by a single thread for a given testcase.
+ *
+ * @details Threads capture results into their own buffers, which are
+ *          merged into their testcase when it is saved or posted. The
+ *          mutex of a buffer is only contended while it is merged.
+ *          If the testcase allocates its results from an arena, each
+ *          buffer has an arena of its own, from which values captured by
+ *          its thread are allocated and which is handed over to the
+ *          testcase along with those values.
+ */
+class TOUCA_CLIENT_API capture_buffer {
+ public:
+  capture_buffer(const Testcase::Metadata& meta, const bool arena);
+
+  void check(const touca::key& key, data_point value);
+
+  void assume(const touca::key& key, data_point value);
+
+  void add_array_element(const touca::key& key, data_point value);
+
+  void add_hit_count(const touca::key& key);
+
+  void add_results(detail::result_list checks,
+                   detail::result_list assumptions);
+
+  /**
+   * Moves results captured so far into a given testcase. Checks and
+   * assumptions that the testcase already has are kept. Array elements
+   * and hit counts are added to those of the testcase. The testcase
+   * keeps the arena of this buffer, if any, until its results are
+   * cleared.
+   *
+   * @return keys whose results were dropped since they have a different
+   *         type in the testcase.
+   */
+  std::vector<std::string> merge_into(Testcase& testcase);
+
+ private:
+  friend class capture_scope;
+
+  // recursive since a `capture_scope` holds it while it adds results
+  std::recursive_mutex _mutex;
+  Testcase _results;
+  // arena of our results, shared with testcases they are merged into
+  std::shared_ptr<arena> _arena;
+  // hashes of keys that were captured by `add_array_element` or
+  // `add_hit_count` and should be accumulated during merge.
+  std::unordered_set<std::uint64_t> _accumulated;
+};
+
+/**
+ * @brief Elements appended to an array result through an appender.
+ *
+ * @details Elements are stored in chunks of fixed capacity so that
+ *          appending an element never moves the elements appended
+ *          before it. Chunks are spliced into the array result of their
+ *          testcase when it is saved or posted.
+ */
+class TOUCA_CLIENT_API array_sink {
+ public:
+  /**
+   * @param element_type `internal_type::array` for a sink of elements of
+   *                     any type, or the type of numbers that this sink
+   *                     stores in packed chunks.
+   */
+  explicit array_sink(const internal_type element_type);
+
+  void append(data_point value);
+
+  void append(const number_signed_t value);
+
+  void append(const number_unsigned_t value);
+
+  void append(const number_float_t value);
+
+  void append(const number_double_t value);
+
+  /**
+   * Appends elements captured so far to the array result of a given key
+   * in a given testcase.
+   *
+   * @return false if elements were dropped since the result of the key
+   *         is not an array.
+   */
+  bool merge_into(Testcase& testcase, const std::string& name);
+
+ private:
+  template <typename T>
+  void append_packed(const T value);
+
+  data_point& chunk();
+
+  std::mutex _mutex;
+  internal_type _element_type;
+  std::vector<data_point> _chunks;
+};
+
+/**
+ * @brief Testcase declared by a client along with the capture buffers of
+ *        the threads that add results to it.
+ */
+class TOUCA_CLIENT_API testcase_entry {
+ public:
+  testcase_entry(std::shared_ptr<Testcase> testcase, const bool arena);
+
+  /**
+   * @return capture buffer of the calling thread, created on first use.
+   */
+  std::shared_ptr<capture_buffer> buffer();
+
+  void tic(const std::string& key);
+
+  void toc(const std::string& key);
+
+  /**
+   * @return counter of hits of a given key, created on first use. Hits
+   *         counted so far are added to the testcase when it is flushed.
+   */
+  std::shared_ptr<std::atomic<std::uint64_t>> counter(const touca::key& key);
+
+  /**
+   * @return new sink of elements of the array result of a given key.
+   *         Elements appended so far are added to the testcase when it
+   *         is flushed.
+   */
+  std::shared_ptr<array_sink> sink(const touca::key& key,
+                                   const internal_type element_type);
+
+  /**
+   * Merges results in all capture buffers, array sinks and hit counters
+   * into the testcase.
+   *
+   * @return keys whose results were dropped during merge
+   */
+  std::vector<std::string> flush();
+
+  /**
+   * Calls a given function with the testcase, while no capture buffer
+   * is merged into it.
+   */
+  void apply(const std::function<void(Testcase&)>& func);
+
+  const std::shared_ptr<Testcase>& testcase() const { return _testcase; }
+
+  /**
+   * Marks this testcase as forgotten, after which threads that still
+   * refer to it should no longer capture results for it and release it
+   * once they attempt to.
+   */
+  void forget() { _forgotten.store(true, std::memory_order_release); }
+
+  bool forgotten() const { return _forgotten.load(std::memory_order_acquire); }
+
+ private:
+  std::mutex _mutex;
+  std::shared_ptr<Testcase> _testcase;
+  std::unordered_map<std::thread::id, std::shared_ptr<capture_buffer>>
+      _buffers;
+  std::map<std::string, std::shared_ptr<std::atomic<std::uint64_t>>>
+      _counters;
+  std::vector<std::pair<std::string, std::shared_ptr<array_sink>>> _sinks;
+  std::atomic<bool> _forgotten;
+  bool _arena;
+};
+
+/**
+ * @brief Testcases declared by a client, sharded by their name so that
+ *        threads declaring different testcases rarely contend.
+ */
+class TOUCA_CLIENT_API testcase_registry {
+ public:
+  using entry_ptr = std::shared_ptr<testcase_entry>;
+
+  /**
+   * @return entry of testcase with the given name, created by calling
+   *         `create` if it does not exist.
+   */
+  entry_ptr find_or_create(const std::string& name,
+                           const std::function<entry_ptr()>& create);
+
+  /**
+   * @return entry of testcase with the given name or `nullptr`
+   */
+  entry_ptr find(const std::string& name) const;
+
+  /**
+   * Removes testcase with the given name.
+   *
+   * @return removed entry or `nullptr` if no such testcase exists
+   */
+  entry_ptr erase(const std::string& name);
+
+  /**
+   * @return all testcases, sorted by name
+   */
+  std::vector<std::pair<std::string, entry_ptr>> entries() const;
+
+ private:
+  struct shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, entry_ptr> entries;
+  };
+
+  shard& shard_of(const std::string& name) const;
+
+  mutable std::array<shard, 16> _shards;
+};
+
+/**
+ * @brief Testcase that a thread captures results for, as seen by that
+ *        thread.
+ */
+struct capture_state {
+  std::shared_ptr<testcase_entry> entry;
+  std::shared_ptr<capture_buffer> buffer;
+  // number of declarations of the client when this state was updated
+  std::uint64_t declarations = 0u;
+  // whether the testcase was installed by a `context_scope`, in which
+  // case declarations by other threads do not change it.
+  bool pinned = false;
+
+  void bind(std::shared_ptr<testcase_entry> next);
+};
+
+}  // namespace detail
+}  // namespace touca
@@ -2,10 +2,14 @@
 
 #pragma once
 
-#include <thread>
+#include <atomic>
+#include <future>
+#include <mutex>
 #include <unordered_map>
 
+#include "touca/client/detail/capture.hpp"
 #include "touca/client/detail/options.hpp"
+#include "touca/client/detail/submission.hpp"
 #include "touca/core/filesystem.hpp"
 #include "touca/core/testcase.hpp"
 #include "touca/devkit/platform.hpp"
@@ -26,11 +30,17 @@ enum class DataFormat : unsigned char {
 
 /**
  * We are exposing this class for convenient unit-testing.
+ *
+ * Safe to use from multiple threads once configured. Each thread
+ * captures results into its own buffer that is merged into the testcase
+ * when the testcase is saved or posted.
  */
 class TOUCA_CLIENT_API ClientImpl {
  public:
   using OptionsMap = std::unordered_map<std::string, std::string>;
 
+  ClientImpl();
+
   bool configure(const ClientImpl::OptionsMap& options);
 
   bool configure(const ClientOptions& options = ClientOptions());
@@ -51,13 +61,64 @@ class TOUCA_CLIENT_API ClientImpl {
 
   void forget_testcase(const std::string& name);
 
-  void check(const std::string& key, const data_point& value);
+  /**
+   * @return testcase with the given name along with the capture buffers
+   *         of its threads, or `nullptr` if no such testcase is declared.
+   */
+  std::shared_ptr<detail::testcase_entry> find_testcase(
+      const std::string& name) const;
+
+  /**
+   * @return testcase that results captured by the calling thread are
+   *         added to, or `nullptr` if there is no such testcase.
+   */
+  std::shared_ptr<detail::testcase_entry> current_testcase() const;
+
+  /**
+   * @return capture buffer that results captured by the calling thread
+   *         are added to, or `nullptr` if there is no such buffer.
+   */
+  std::shared_ptr<detail::capture_buffer> current_buffer() const;
+
+  /**
+   * Makes the calling thread capture results for a given testcase,
+   * regardless of testcases declared by other threads, until the
+   * returned state is restored via `leave_context`.
+   *
+   * @param entry testcase to capture results for, or `nullptr` to
+   *              capture no result
+   *
+   * @return previous state of the calling thread
+   */
+  detail::capture_state enter_context(
+      std::shared_ptr<detail::testcase_entry> entry);
+
+  /**
+   * Restores a state of the calling thread previously returned by
+   * `enter_context`.
+   */
+  void leave_context(detail::capture_state previous);
+
+  /**
+   * @return whether results captured by the calling thread are added to
+   *         a testcase. Always false if the client is not configured.
+   */
+  bool has_last_testcase() const;
+
+  void check(const touca::key& key, data_point value);
 
-  void assume(const std::string& key, const data_point& value);
+  void assume(const touca::key& key, data_point value);
 
-  void add_array_element(const std::string& key, const data_point& value);
+  void add_array_element(const touca::key& key, data_point value);
 
-  void add_hit_count(const std::string& key);
+  /**
+   * Adds a list of checks and a list of assumptions to the testcase of
+   * the calling thread, looking up the testcase only once.
+   */
+  void add_results(detail::result_list checks,
+                   detail::result_list assumptions);
+
+  void add_hit_count(const touca::key& key);
 
   void add_metric(const std::string& key, const unsigned duration);
 
@@ -71,39 +132,101 @@ class TOUCA_CLIENT_API ClientImpl {
 
   bool post() const;
 
+  /**
+   * Blocks until results posted in the background, if any, are
+   * submitted to the server.
+   *
+   * @return false if any of those results could not be submitted
+   */
+  bool flush() const;
+
   bool seal() const;
 
  private:
   bool apply_options();
 
-  std::string get_last_testcase() const;
-
-  bool has_last_testcase() const;
-
-  std::vector<Testcase> find_testcases(
+  /**
+   * @return state of the testcase that results captured by the calling
+   *         thread are added to, or `nullptr` if there is no such
+   *         testcase.
+   */
+  detail::capture_state* get_last_testcase() const;
+
+  void merge(detail::testcase_entry& entry) const;
+
+  /**
+   * Finds entries of testcases with given names, after merging results
+   * captured for them. Testcases are borrowed from their entries rather
+   * than copied, so callers should access them via `apply`.
+   */
+  std::vector<std::shared_ptr<detail::testcase_entry>> find_testcases(
       const std::vector<std::string>& names) const;
 
-  void save_json(const touca::filesystem::path& path,
-                 const std::vector<Testcase>& testcases) const;
-
-  void save_flatbuffers(const touca::filesystem::path& path,
-                        const std::vector<Testcase>& testcases) const;
-
-  bool post_flatbuffers(const std::vector<Testcase>& testcases) const;
+  void save_json(
+      const touca::filesystem::path& path,
+      const std::vector<std::shared_ptr<detail::testcase_entry>>& entries)
+      const;
+
+  void save_flatbuffers(
+      const touca::filesystem::path& path,
+      const std::vector<std::shared_ptr<detail::testcase_entry>>& entries)
+      const;
+
+  /**
+   * Submits given testcases to the server in requests of up to
+   * `post_batch_bytes` each.
+   *
+   * @param messages serialized form of each of the given testcases,
+   *                 taken when they were posted.
+   * @return indices of the testcases whose request was not successful
+   */
+  std::vector<std::size_t> post_flatbuffers(
+      const std::vector<std::shared_ptr<detail::testcase_entry>>& entries,
+      const std::vector<std::shared_ptr<const std::vector<uint8_t>>>&
+          messages) const;
 
   void notify_loggers(const touca::logger::Level severity,
                       const std::string& msg) const;
 
+  /**
+   * Waits for authentication to the server, if it is performed in the
+   * background, and reports whether results can be submitted.
+   */
   bool is_platform_ready() const;
 
+  /**
+   * Takes a writer from the writers kept between calls to `save` and
+   * `post`, or creates one if none is available.
+   */
+  std::unique_ptr<detail::messages_writer> acquire_writer() const;
+
+  void release_writer(std::unique_ptr<detail::messages_writer> writer) const;
+
   bool _configured = false;
   std::string _config_error;
   ClientOptions _options;
-  ElementsMap _testcases;
-  std::string _mostRecentTestcase;
+  detail::testcase_registry _testcases;
+  std::shared_ptr<detail::testcase_entry> _mostRecentTestcase;
+  mutable std::mutex _mostRecentMutex;
+  // incremented whenever the most recent testcase changes, so that
+  // threads notice the change without taking a lock.
+  std::atomic<std::uint64_t> _declarations;
+  // identifies this client among states of the calling thread
+  const std::uint64_t _id;
   std::unique_ptr<Platform> _platform;
-  std::unordered_map<std::thread::id, std::string> _threadMap;
   std::vector<std::shared_ptr<touca::logger>> _loggers;
+  // loggers are notified by the threads that authenticate and submit
+  // results in the background, too.
+  mutable std::mutex _loggers_mutex;
+  mutable std::mutex _writers_mutex;
+  mutable std::vector<std::unique_ptr<detail::messages_writer>> _writers;
+  // outcome of authenticating to the server, which is an error message
+  // if it failed. declared after the members that authentication uses
+  // so that it waits for authentication before they are destroyed.
+  std::shared_future<std::string> _session;
+  // declared last so that it is destroyed, and submits results that are
+  // still queued, before the members that its submissions use.
+  std::unique_ptr<detail::submission_queue> _submissions;
 };
 
 }  // namespace touca
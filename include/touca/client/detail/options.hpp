@@ -17,6 +17,13 @@ struct ClientOptions {
   std::string revision; /**< Team to which this suite belongs */
   bool offline = false; /**< Perform server handshake during configuration */
   bool single_thread = false; /**< Isolates testcase scope to calling thread */
+  bool arena = false; /**< Allocates captured results from testcase arenas */
+  bool async_post = false; /**< Submits results from a background thread */
+  unsigned post_batch_bytes = 4u << 20; /**< Target size of each submission */
+  unsigned post_concurrency = 1u; /**< Maximum number of concurrent requests */
+  unsigned compression_level = 0u; /**< Compression level of submissions */
+  std::string cache_dir; /**< Directory to cache API token and testcases in */
+  unsigned cache_ttl = 600u; /**< Seconds for which cached data is used */
 };
 
 void parse_env_variables(ClientOptions& options);
@@ -0,0 +1,94 @@
+// Copyright 2021 Touca, Inc. Subject to Apache-2.0 License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "touca/lib_api.hpp"
+
+namespace touca {
+namespace detail {
+
+/**
+ * @brief Bounded queue of submissions that are performed, in order, by a
+ *        background thread.
+ *
+ * @details Used by the client to submit test results without blocking
+ *          the thread that posts them on network I/O. Pushing to a full
+ *          queue blocks until the background thread takes a submission
+ *          off the queue, so that a slow server limits how many results
+ *          are held in memory. The background thread is started on the
+ *          first push and is joined when the queue is destroyed, after
+ *          all pushed submissions are performed. Submissions that are
+ *          not successful are kept until they are performed again by
+ *          `wait`.
+ */
+class TOUCA_CLIENT_API submission_queue {
+ public:
+  /**
+   * Submission to be performed by the background thread. Returns whether
+   * it was successful.
+   */
+  using job = std::function<bool()>;
+
+  explicit submission_queue(const std::size_t capacity);
+
+  submission_queue(const submission_queue&) = delete;
+
+  submission_queue& operator=(const submission_queue&) = delete;
+
+  ~submission_queue();
+
+  /**
+   * Adds a given submission to the queue, blocking while the queue is
+   * full.
+   */
+  void push(job submission);
+
+  /**
+   * Blocks until all submissions pushed so far are performed, and then
+   * performs once more each submission that was not successful, in the
+   * order in which they were pushed. Submissions that are still not
+   * successful are kept to be performed again by the next call.
+   *
+   * @return false if any submission is still not successful.
+   */
+  bool wait();
+
+ private:
+  void run();
+
+  std::mutex _mutex;
+  std::condition_variable _pushed;
+  std::condition_variable _popped;
+  std::condition_variable _done;
+  std::deque<job> _jobs;
+  std::size_t _capacity;
+  // number of submissions that are queued or being performed
+  std::size_t _pending = 0u;
+  // submissions that were not successful, to be performed again
+  std::deque<job> _failed;
+  bool _stopped = false;
+  std::thread _worker;
+};
+
+/**
+ * Splits a list of messages into consecutive groups whose total size
+ * does not exceed a given budget. Messages larger than the budget are
+ * placed in a group of their own.
+ *
+ * @param sizes size of each message in bytes
+ * @param budget maximum total size of messages in each group
+ * @return index of the first message of each group
+ */
+TOUCA_CLIENT_API std::vector<std::size_t> split_by_size(
+    const std::vector<std::size_t>& sizes, const std::size_t budget);
+
+}  // namespace detail
+}  // namespace touca
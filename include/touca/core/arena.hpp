@@ -0,0 +1,142 @@
+// Copyright 2021 Touca, Inc. Subject to Apache-2.0 License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "touca/lib_api.hpp"
+
+namespace touca {
+namespace detail {
+
+/**
+ * @brief Monotonic memory resource that hands out memory from a list of
+ *        large blocks and releases all of it at once.
+ *
+ * @details Used by `Testcase` to hold the nodes of the results it
+ *          captures, so that capturing a nested structure does not cost
+ *          one heap allocation per node and forgetting a testcase does
+ *          not cost one deallocation per node. Memory handed out by an
+ *          arena is never reused until the arena is released.
+ *          Not thread-safe.
+ */
+class TOUCA_CLIENT_API arena {
+ public:
+  explicit arena(const std::size_t block_size = 64 * 1024);
+
+  arena(const arena&) = delete;
+
+  arena& operator=(const arena&) = delete;
+
+  ~arena();
+
+  void* allocate(const std::size_t size, const std::size_t alignment);
+
+  /**
+   * Returns all memory held by this arena to the system. Any object
+   * allocated from this arena must be destroyed before this call.
+   */
+  void release() noexcept;
+
+  /**
+   * @return total number of bytes this arena has reserved so far
+   */
+  std::size_t capacity() const noexcept { return _capacity; }
+
+ private:
+  struct block {
+    block* next;
+  };
+
+  block* _head = nullptr;
+  unsigned char* _cursor = nullptr;
+  unsigned char* _end = nullptr;
+  std::size_t _block_size;
+  std::size_t _capacity = 0;
+};
+
+/**
+ * @return the arena that new data points created by the calling thread
+ *         should be allocated from, or `nullptr` if they should be
+ *         allocated on the heap.
+ */
+TOUCA_CLIENT_API arena* active_arena() noexcept;
+
+/**
+ * @brief Makes a given arena the active arena of the calling thread for
+ *        the lifetime of this object.
+ */
+class TOUCA_CLIENT_API arena_scope {
+ public:
+  explicit arena_scope(arena* scope) noexcept;
+
+  arena_scope(const arena_scope&) = delete;
+
+  arena_scope& operator=(const arena_scope&) = delete;
+
+  ~arena_scope();
+
+ private:
+  arena* _previous;
+};
+
+/**
+ * @brief Allocator for containers nested in data points that draws from
+ *        the arena that was active when the container was created.
+ *        Falls back to the heap when no arena was active.
+ */
+template <typename T>
+struct arena_allocator {
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  arena_allocator() noexcept : _arena(active_arena()) {}
+
+  explicit arena_allocator(arena* owner) noexcept : _arena(owner) {}
+
+  template <typename U>
+  arena_allocator(const arena_allocator<U>& other) noexcept
+      : _arena(other._arena) {}
+
+  T* allocate(const std::size_t n) {
+    if (!_arena) {
+      return std::allocator<T>().allocate(n);
+    }
+    return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, const std::size_t n) noexcept {
+    if (!_arena) {
+      std::allocator<T>().deallocate(ptr, n);
+    }
+  }
+
+  /**
+   * Copies of a container are allocated from the arena that is active
+   * at the time of the copy, not from the arena of the original.
+   */
+  arena_allocator select_on_container_copy_construction() const noexcept {
+    return arena_allocator();
+  }
+
+  arena* _arena;
+};
+
+template <typename T, typename U>
+bool operator==(const arena_allocator<T>& lhs,
+                const arena_allocator<U>& rhs) noexcept {
+  return lhs._arena == rhs._arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const arena_allocator<T>& lhs,
+                const arena_allocator<U>& rhs) noexcept {
+  return lhs._arena != rhs._arena;
+}
+
+}  // namespace detail
+}  // namespace touca
@@ -84,5 +84,9 @@ TOUCA_CLIENT_API void save_string_file(const std::string& path,
 TOUCA_CLIENT_API void save_binary_file(const std::string& path,
                                        const std::vector<uint8_t>& content);
 
+TOUCA_CLIENT_API void save_binary_file(const std::string& path,
+                                       const uint8_t* content,
+                                       const std::size_t size);
+
 }  // namespace detail
 }  // namespace touca
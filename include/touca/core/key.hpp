@@ -0,0 +1,108 @@
+// Copyright 2021 Touca, Inc. Subject to Apache-2.0 License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace touca {
+namespace detail {
+
+constexpr std::uint64_t fnv1a_basis = 0xcbf29ce484222325ull;
+constexpr std::uint64_t fnv1a_prime = 0x100000001b3ull;
+
+/**
+ * 64-bit FNV-1a hash of a given string, in a form that may be evaluated
+ * at compile time.
+ */
+constexpr std::uint64_t fnv1a(const char* str, const std::size_t size,
+                              const std::uint64_t hash = fnv1a_basis) {
+  return size == 0u
+             ? hash
+             : fnv1a(str + 1, size - 1,
+                     (hash ^ static_cast<unsigned char>(*str)) * fnv1a_prime);
+}
+
+/**
+ * Length of a null-terminated string, in a form that may be evaluated at
+ * compile time.
+ */
+constexpr std::size_t length(const char* str, const std::size_t size = 0u) {
+  return *str == '\0' ? size : length(str + 1, size + 1);
+}
+
+/**
+ * Same as `fnv1a` but without recursion, for strings known at runtime.
+ */
+inline std::uint64_t fnv1a_runtime(const char* str, const std::size_t size) {
+  auto hash = fnv1a_basis;
+  for (std::size_t i = 0u; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(str[i])) * fnv1a_prime;
+  }
+  return hash;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Name of a captured result along with its precomputed hash.
+ *
+ * @details Data capturing functions accept keys in place of strings.
+ *          Testcases use the hash of a key to find results that were
+ *          previously captured with the same key, without comparing the
+ *          key to the names of other results. String literals are
+ *          converted to keys implicitly and their hash may be computed
+ *          at compile time:
+ *
+ *          @code
+ *              constexpr touca::key latency("latency");
+ *              for (const auto& request : requests) {
+ *                touca::add_array_element(latency, handle(request));
+ *              }
+ *          @endcode
+ *
+ *          A key refers to the string it is constructed from and should
+ *          not outlive it.
+ */
+class key {
+ public:
+  template <std::size_t N>
+  constexpr key(const char (&name)[N])
+      : _data(name),
+        _size(detail::length(name)),
+        _hash(detail::fnv1a(name, detail::length(name))) {}
+
+  template <typename T, typename = typename std::enable_if<
+                            std::is_same<T, const char*>::value ||
+                            std::is_same<T, char*>::value>::type>
+  key(T name)
+      : _data(name),
+        _size(std::char_traits<char>::length(name)),
+        _hash(detail::fnv1a_runtime(_data, _size)) {}
+
+  key(const std::string& name)
+      : _data(name.data()),
+        _size(name.size()),
+        _hash(detail::fnv1a_runtime(_data, _size)) {}
+
+  constexpr const char* data() const { return _data; }
+
+  constexpr std::size_t size() const { return _size; }
+
+  constexpr std::uint64_t hash() const { return _hash; }
+
+  std::string str() const { return std::string(_data, _size); }
+
+  bool operator==(const std::string& other) const {
+    return other.size() == _size && 0 == other.compare(0, _size, _data, _size);
+  }
+
+ private:
+  const char* _data;
+  std::size_t _size;
+  std::uint64_t _hash;
+};
+
+}  // namespace touca
@@ -114,6 +114,33 @@ template <typename T>
 using is_touca_array =
     conjunction<negation<is_touca_string<T>>, detail::is_iterable<T>>;
 
+template <typename T, typename = void>
+struct packed_element {
+  using type = void;
+};
+
+/**
+ * Type in which we store elements of an iterable of numbers in a packed
+ * array, or `void` if elements of `T` are not numbers.
+ */
+template <typename T>
+struct packed_element<T, enable_if_t<is_touca_array<T>::value>> {
+  using element_type =
+      remove_cv_ref_t<decltype(*std::begin(std::declval<T>()))>;
+  using type = typename std::conditional<
+      is_touca_number_signed<element_type>::value, number_signed_t,
+      typename std::conditional<
+          is_touca_number_unsigned<element_type>::value, number_unsigned_t,
+          typename std::conditional<
+              is_touca_number_float<element_type>::value ||
+                  is_touca_number_double<element_type>::value,
+              element_type, void>::type>::type>::type;
+};
+
+template <typename T>
+using is_touca_packed_array =
+    negation<std::is_void<typename packed_element<T>::type>>;
+
 template <typename T>
 enable_if_t<std::is_convertible<T, std::string>::value, std::string> to_string(
     const T& value) {
@@ -179,7 +206,9 @@ struct serializer<T, detail::enable_if_t<detail::is_touca_string<T>::value>> {
 };
 
 template <typename T>
-struct serializer<T, detail::enable_if_t<detail::is_touca_array<T>::value>> {
+struct serializer<
+    T, detail::enable_if_t<detail::is_touca_array<T>::value &&
+                           !detail::is_touca_packed_array<T>::value>> {
   data_point serialize(const T& values) {
     array out;
     for (const auto& v : values) {
@@ -189,6 +218,22 @@ struct serializer<T, detail::enable_if_t<detail::is_touca_array<T>::value>> {
   }
 };
 
+template <typename T>
+struct serializer<
+    T, detail::enable_if_t<detail::is_touca_packed_array<T>::value>> {
+  data_point serialize(const T& values) {
+    using element_type = typename detail::packed_element<T>::type;
+    using traits = detail::packed_traits<element_type>;
+    detail::packed_array_t out(traits::type);
+    auto& elements = traits::values(out);
+    elements.reserve(std::distance(std::begin(values), std::end(values)));
+    for (const auto& v : values) {
+      elements.push_back(static_cast<element_type>(v));
+    }
+    return out;
+  }
+};
+
 template <typename T>
 struct serializer<
     T, detail::enable_if_t<detail::is_specialization<T, std::pair>::value>> {
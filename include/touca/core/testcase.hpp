@@ -4,15 +4,22 @@
 
 #include <chrono>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "nlohmann/json_fwd.hpp"
+#include "touca/core/key.hpp"
 #include "touca/core/types.hpp"
 #include "touca/lib_api.hpp"
 
 namespace touca {
 class ClientImpl;
 class TestcaseComparison;
+namespace detail {
+class array_sink;
+class capture_buffer;
+}  // namespace detail
 
 enum class ResultCategory { Check = 1, Assert };
 
@@ -31,6 +38,8 @@ using ResultsMap = std::map<std::string, ResultEntry>;
 class TOUCA_CLIENT_API Testcase {
   friend class ClientImpl;
   friend class TestcaseComparison;
+  friend class detail::array_sink;
+  friend class detail::capture_buffer;
 
  public:
   struct TOUCA_CLIENT_API Overview {
@@ -57,20 +66,45 @@ class TOUCA_CLIENT_API Testcase {
            const std::unordered_map<std::string, detail::number_unsigned_t>&
                metrics);
 
+  /**
+   * @param arena whether the results captured for this testcase should
+   *              be allocated from an arena owned by this testcase that
+   *              is released in one step when the testcase is cleared
+   *              or destroyed.
+   */
   Testcase(const std::string& teamslug, const std::string& testsuite,
-           const std::string& version, const std::string& name);
+           const std::string& version, const std::string& name,
+           const bool arena = false);
+
+  Testcase(const Testcase& other) = default;
+
+  Testcase(Testcase&& other) = default;
+
+  /**
+   * Releases results of this testcase before the arena that they may be
+   * allocated from, and then takes the results of the other testcase.
+   */
+  Testcase& operator=(const Testcase& other);
+
+  Testcase& operator=(Testcase&& other);
 
   void tic(const std::string& key);
 
   void toc(const std::string& key);
 
-  void check(const std::string& key, const data_point& value);
+  void check(const touca::key& key, data_point value);
 
-  void assume(const std::string& key, const data_point& value);
+  void assume(const touca::key& key, data_point value);
 
-  void add_array_element(const std::string& key, const data_point& value);
+  void add_array_element(const touca::key& key, data_point value);
 
-  void add_hit_count(const std::string& key);
+  /**
+   * Adds a list of results in one step. Like `check` and `assume`,
+   * results whose key is already associated with a result are ignored.
+   */
+  void add_results(detail::result_list results, const ResultCategory category);
+
+  void add_hit_count(const touca::key& key, const std::uint64_t count = 1u);
 
   void add_metric(const std::string& key, const unsigned duration);
 
@@ -86,6 +120,24 @@ class TOUCA_CLIENT_API Testcase {
 
   std::vector<uint8_t> flatbuffers() const;
 
+  /**
+   * Provides the serialized representation of this testcase in
+   * flatbuffers format. The serialized form is cached until this
+   * testcase is changed or `release_message` is called, and is shared
+   * with copies of this testcase, so that a testcase that is both saved
+   * and posted is serialized only once.
+   *
+   * @return serialized binary data in flatbuffers format
+   */
+  std::shared_ptr<const std::vector<uint8_t>> message() const;
+
+  /**
+   * Drops the serialized form cached by `message()` once it is not
+   * expected to be used again, such as after this testcase is posted,
+   * so that it is not kept alongside the results of this testcase.
+   */
+  void release_message() const;
+
   Metadata metadata() const;
 
   void setMetadata(const Metadata& metadata);
@@ -101,15 +153,129 @@ class TOUCA_CLIENT_API Testcase {
    */
   static std::vector<uint8_t> serialize(const std::vector<Testcase>& testcases);
 
+  /**
+   * Wraps a given list of testcases, each already serialized via
+   * `message()`, into binary data compliant with Touca flatbuffers
+   * schema.
+   *
+   * @param buffers list of serialized testcases
+   * @return serialized binary data in flatbuffers format
+   */
+  static std::vector<uint8_t> serialize(
+      const std::vector<std::shared_ptr<const std::vector<uint8_t>>>& buffers);
+
  private:
+  /**
+   * Maps hashes of keys to entries of the results map. Not carried over
+   * to copies of a testcase, since iterators do not refer to the results
+   * map of the copy.
+   */
+  struct KeyIndex {
+    KeyIndex() = default;
+    KeyIndex(const KeyIndex&) {}
+    KeyIndex& operator=(const KeyIndex&) {
+      entries.clear();
+      return *this;
+    }
+    std::unordered_map<std::uint64_t, ResultsMap::iterator> entries;
+  };
+
+  /**
+   * Outcome of looking up the result of a key. If the key has no result,
+   * refers to where its result belongs and holds its name, so that the
+   * result is inserted without searching or building the name again.
+   */
+  struct ResultSlot {
+    ResultsMap::iterator it;
+    bool found;
+    std::string name;
+  };
+
+  ResultSlot find_result(const touca::key& key);
+
+  /**
+   * Adds the result of a key that `find_result` did not find. The key is
+   * indexed once it is looked up again, so that keys captured only once
+   * do not pay for their index entry.
+   */
+  ResultsMap::iterator insert_result(ResultSlot& slot, ResultEntry entry);
+
+  /**
+   * Serialized form of a testcase. Shared with copies of the testcase
+   * until either of them is changed.
+   */
+  struct Serialized {
+    std::mutex mutex;
+    std::shared_ptr<const std::vector<uint8_t>> message;
+  };
+
+  /**
+   * Marks this testcase as changed since it was last posted and drops
+   * its serialized form.
+   */
+  void invalidate();
+
+  std::vector<uint8_t> build_message() const;
+
   bool _posted;
   Metadata _metadata;
+  // declared ahead of results so that it outlives the nodes it holds.
+  // shared with copies of this testcase whose results may still refer
+  // to it.
+  std::shared_ptr<detail::arena> _arena;
+  // arenas of capture buffers whose results were moved into this
+  // testcase. kept until the results are cleared.
+  std::vector<std::shared_ptr<detail::arena>> _adopted;
   ResultsMap _resultsMap;
+  KeyIndex _keyIndex;
 
   std::unordered_map<std::string, std::chrono::system_clock::time_point> _tics;
   std::unordered_map<std::string, std::chrono::system_clock::time_point> _tocs;
+  mutable std::shared_ptr<Serialized> _serialized;
 };
 
 using ElementsMap = std::unordered_map<std::string, std::shared_ptr<Testcase>>;
 
+namespace detail {
+
+/**
+ * @brief Wraps lists of serialized testcases into binary data compliant
+ *        with Touca flatbuffers schema.
+ *
+ * @details Keeps the memory of its builder across calls and sizes it up
+ *          front to fit the given testcases, so that writing batches of
+ *          similar size neither copies the output nor allocates again.
+ */
+class TOUCA_CLIENT_API messages_writer {
+ public:
+  messages_writer();
+
+  messages_writer(const messages_writer&) = delete;
+
+  messages_writer& operator=(const messages_writer&) = delete;
+
+  ~messages_writer();
+
+  /**
+   * Writes a given list of testcases, each already serialized via
+   * `Testcase::message()`, replacing the output of the previous call.
+   */
+  void write(
+      const std::vector<std::shared_ptr<const std::vector<uint8_t>>>& messages);
+
+  /**
+   * @return pointer to the output of the most recent call to `write`,
+   *         valid until the next call.
+   */
+  const uint8_t* data() const;
+
+  std::size_t size() const;
+
+ private:
+  std::unique_ptr<flatbuffers::FlatBufferBuilder> _builder;
+  std::size_t _capacity = 0u;
+};
+
+}  // namespace detail
+
 }  // namespace touca
@@ -2,17 +2,20 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
 #include <map>
 #include <memory>
+#include <new>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "nlohmann/json_fwd.hpp"
+#include "touca/core/arena.hpp"
 #include "touca/lib_api.hpp"
 
 namespace flatbuffers {
@@ -41,30 +44,47 @@ enum class TOUCA_CLIENT_API internal_type : std::uint8_t {
   number_unsigned,
   number_float,
   number_double,
+  packed_array,
   unknown
 };
 
+/**
+ * Number of bytes reserved in front of each node allocated by `create`
+ * to remember the arena that the node was allocated from, if any.
+ */
+template <typename T>
+constexpr std::size_t node_offset() {
+  return (sizeof(arena*) + alignof(T) - 1) / alignof(T) * alignof(T);
+}
+
 template <typename T, typename... Args>
 static T* create(Args&&... args) {
-  std::allocator<T> alloc;
-  using AllocatorTraits = std::allocator_traits<std::allocator<T>>;
-
-  auto deleter = [&](T* obj) { AllocatorTraits::deallocate(alloc, obj, 1); };
-  std::unique_ptr<T, decltype(deleter)> obj(AllocatorTraits::allocate(alloc, 1),
-                                            deleter);
-  AllocatorTraits::construct(alloc, obj.get(), std::forward<Args>(args)...);
-  return obj.release();
+  const auto owner = active_arena();
+  const auto length = node_offset<T>() + sizeof(T);
+  auto deleter = [owner](unsigned char* raw) {
+    if (!owner) ::operator delete(raw);
+  };
+  std::unique_ptr<unsigned char, decltype(deleter)> raw(
+      static_cast<unsigned char*>(
+          owner ? owner->allocate(length, (std::max)(alignof(T),
+                                                     alignof(arena*)))
+                : ::operator new(length)),
+      deleter);
+  *reinterpret_cast<arena**>(raw.get()) = owner;
+  auto obj = new (raw.get() + node_offset<T>()) T(std::forward<Args>(args)...);
+  raw.release();
+  return obj;
 }
 
 template <typename T>
 static void destroy(T* ptr) {
   if (!ptr) return;
 
-  std::allocator<T> alloc;
-  using AllocatorTraits = std::allocator_traits<std::allocator<T>>;
-
-  AllocatorTraits::destroy(alloc, ptr);
-  AllocatorTraits::deallocate(alloc, ptr, 1);
+  auto raw = reinterpret_cast<unsigned char*>(ptr) - node_offset<T>();
+  const auto owner = *reinterpret_cast<arena**>(raw);
+  ptr->~T();
+  // nodes allocated from an arena are reclaimed when the arena is released
+  if (!owner) ::operator delete(raw);
 }
 
 template <typename T, typename U = T>
@@ -74,8 +94,10 @@ static T exchange(T& lhs, U&& rhs) {
   return ret;
 }
 
-using object_t = std::map<std::string, data_point>;
-using array_t = std::vector<data_point>;
+using object_t =
+    std::map<std::string, data_point, std::less<std::string>,
+             arena_allocator<std::pair<const std::string, data_point>>>;
+using array_t = std::vector<data_point, arena_allocator<data_point>>;
 using string_t = std::string;
 using boolean_t = bool;
 using number_signed_t = int64_t;
@@ -83,21 +105,153 @@ using number_unsigned_t = uint64_t;
 using number_float_t = float;
 using number_double_t = double;
 
+/**
+ * Structural fingerprint of a data point. Zero indicates that the
+ * fingerprint of a node was never computed.
+ */
+using fingerprint_t = std::uint64_t;
+
+/**
+ * Fingerprint reserved for values that never compare as identical to
+ * any other value, such as NaN, and for nodes that contain them.
+ */
+constexpr fingerprint_t unmatched_fingerprint = 1u;
+
+/**
+ * Storage of an array node, along with the cached fingerprint of its
+ * elements.
+ */
+struct array_node {
+  array_t elements;
+  mutable fingerprint_t fingerprint = 0u;
+};
+
+/**
+ * Storage of an object node. The type name of the object is kept here,
+ * rather than in `data_point`, so that scalars and array elements, which
+ * make up the bulk of captured results, fit in a 16-byte `data_point`.
+ */
+struct object_node {
+  object_node() = default;
+
+  explicit object_node(string_t name) : name(std::move(name)) {}
+
+  string_t name;
+  object_t members;
+  mutable fingerprint_t fingerprint = 0u;
+};
+
+template <typename T>
+using packed_values_t = std::vector<T, arena_allocator<T>>;
+
+/**
+ * Storage of an array of numbers of the same type, kept contiguous so
+ * that it can be serialized and compared without creating a separate
+ * `data_point` for each element. Only the values that match
+ * `element_type` are ever populated.
+ */
+struct packed_array_t {
+  explicit packed_array_t(const internal_type element_type)
+      : element_type(element_type) {}
+
+  std::size_t size() const noexcept {
+    switch (element_type) {
+      case internal_type::number_signed:
+        return signed_values.size();
+      case internal_type::number_unsigned:
+        return unsigned_values.size();
+      case internal_type::number_float:
+        return float_values.size();
+      default:
+        return double_values.size();
+    }
+  }
+
+  internal_type element_type;
+  mutable fingerprint_t fingerprint = 0u;
+  packed_values_t<number_signed_t> signed_values;
+  packed_values_t<number_unsigned_t> unsigned_values;
+  packed_values_t<number_float_t> float_values;
+  packed_values_t<number_double_t> double_values;
+};
+
+/**
+ * Maps each numeric type that we can store in a `packed_array_t` to its
+ * internal type and to the values of the packed array that hold it.
+ */
+template <typename T>
+struct packed_traits;
+
+template <>
+struct packed_traits<number_signed_t> {
+  static constexpr internal_type type = internal_type::number_signed;
+  static packed_values_t<number_signed_t>& values(packed_array_t& packed) {
+    return packed.signed_values;
+  }
+  static const packed_values_t<number_signed_t>& values(
+      const packed_array_t& packed) {
+    return packed.signed_values;
+  }
+};
+
+template <>
+struct packed_traits<number_unsigned_t> {
+  static constexpr internal_type type = internal_type::number_unsigned;
+  static packed_values_t<number_unsigned_t>& values(packed_array_t& packed) {
+    return packed.unsigned_values;
+  }
+  static const packed_values_t<number_unsigned_t>& values(
+      const packed_array_t& packed) {
+    return packed.unsigned_values;
+  }
+};
+
+template <>
+struct packed_traits<number_float_t> {
+  static constexpr internal_type type = internal_type::number_float;
+  static packed_values_t<number_float_t>& values(packed_array_t& packed) {
+    return packed.float_values;
+  }
+  static const packed_values_t<number_float_t>& values(
+      const packed_array_t& packed) {
+    return packed.float_values;
+  }
+};
+
+template <>
+struct packed_traits<number_double_t> {
+  static constexpr internal_type type = internal_type::number_double;
+  static packed_values_t<number_double_t>& values(packed_array_t& packed) {
+    return packed.double_values;
+  }
+  static const packed_values_t<number_double_t>& values(
+      const packed_array_t& packed) {
+    return packed.double_values;
+  }
+};
+
+/**
+ * Grants read access to nodes of a data point without discarding their
+ * cached fingerprints.
+ */
+struct node_access;
+
 }  // namespace detail
 
 struct TOUCA_CLIENT_API array final {
   friend class data_point;
 
  public:
-  array() : _v(detail::create<detail::array_t>()) {}
+  array() : _v(detail::create<detail::array_node>()) {}
 
-  array(const array& other) : _v(detail::create<detail::array_t>(*other._v)) {}
+  array(const array& other)
+      : _v(detail::create<detail::array_node>(*other._v)) {}
 
   array(array&& other) noexcept : _v(detail::exchange(other._v, nullptr)) {}
 
   array& operator=(const array& other) {
-    detail::destroy<detail::array_t>(_v);
-    _v = detail::create<detail::array_t>(*other._v);
+    detail::destroy<detail::array_node>(_v);
+    _v = detail::create<detail::array_node>(*other._v);
     return *this;
   }
 
@@ -106,24 +260,27 @@ struct TOUCA_CLIENT_API array final {
     return *this;
   }
 
-  ~array() { detail::destroy<detail::array_t>(_v); }
+  ~array() { detail::destroy<detail::array_node>(_v); }
 
   template <typename T>
   array& add(T&& value) {
     using type =
         typename std::remove_cv<typename std::remove_reference<T>::type>::type;
-    _v->push_back(serializer<type>().serialize(std::forward<T>(value)));
+    _v->elements.push_back(
+        serializer<type>().serialize(std::forward<T>(value)));
     return *this;
   }
 
-  detail::array_t::iterator begin() { return _v->begin(); }
-  detail::array_t::iterator end() { return _v->end(); }
+  detail::array_t::iterator begin() { return _v->elements.begin(); }
+  detail::array_t::iterator end() { return _v->elements.end(); }
 
-  detail::array_t::const_iterator cbegin() const { return _v->cbegin(); }
-  detail::array_t::const_iterator cend() const { return _v->cend(); }
+  detail::array_t::const_iterator cbegin() const {
+    return _v->elements.cbegin();
+  }
+  detail::array_t::const_iterator cend() const { return _v->elements.cend(); }
 
  private:
-  detail::array_t* _v;
+  detail::array_node* _v;
 };
 
 class TOUCA_CLIENT_API object final {
@@ -131,37 +288,35 @@ class TOUCA_CLIENT_API object final {
   friend void to_json(nlohmann::json& out, const data_point& value);
 
  public:
-  object() : name(), _v(detail::create<detail::object_t>()) {}
+  object() : _v(detail::create<detail::object_node>()) {}
 
   object(std::string name)
-      : name(std::move(name)), _v(detail::create<detail::object_t>()) {}
+      : _v(detail::create<detail::object_node>(std::move(name))) {}
 
   object(const object& other)
-      : name(other.name), _v(detail::create<detail::object_t>(*other._v)) {}
+      : _v(detail::create<detail::object_node>(*other._v)) {}
 
-  object(object&& other) noexcept
-      : name(std::move(other.name)), _v(detail::exchange(other._v, nullptr)) {}
+  object(object&& other) noexcept : _v(detail::exchange(other._v, nullptr)) {}
 
   object& operator=(const object& other) {
-    name = other.name;
-    detail::destroy<detail::object_t>(_v);
-    _v = detail::create<detail::object_t>(*other._v);
+    detail::destroy<detail::object_node>(_v);
+    _v = detail::create<detail::object_node>(*other._v);
     return *this;
   }
 
   object& operator=(object&& other) noexcept {
-    name = std::move(other.name);
     std::swap(_v, other._v);
     return *this;
   }
 
-  ~object() { detail::destroy<detail::object_t>(_v); }
+  ~object() { detail::destroy<detail::object_node>(_v); }
 
   template <typename T>
   object& add(const std::string& key, T&& value) {
     using type =
         typename std::remove_cv<typename std::remove_reference<T>::type>::type;
-    _v->emplace(key, serializer<type>().serialize(std::forward<T>(value)));
+    _v->members.emplace(key,
+                        serializer<type>().serialize(std::forward<T>(value)));
     return *this;
   }
 
@@ -169,20 +324,21 @@ class TOUCA_CLIENT_API object final {
   object& add(std::string&& key, T&& value) {
     using type =
         typename std::remove_cv<typename std::remove_reference<T>::type>::type;
-    _v->emplace(std::move(key),
-                serializer<type>().serialize(std::forward<T>(value)));
+    _v->members.emplace(std::move(key),
+                        serializer<type>().serialize(std::forward<T>(value)));
     return *this;
   }
 
-  detail::object_t::iterator begin() { return _v->begin(); }
-  detail::object_t::iterator end() { return _v->end(); }
+  detail::object_t::iterator begin() { return _v->members.begin(); }
+  detail::object_t::iterator end() { return _v->members.end(); }
 
-  detail::object_t::const_iterator cbegin() const { return _v->cbegin(); }
-  detail::object_t::const_iterator cend() const { return _v->cend(); }
+  detail::object_t::const_iterator cbegin() const {
+    return _v->members.cbegin();
+  }
+  detail::object_t::const_iterator cend() const { return _v->members.cend(); }
 
  private:
-  std::string name;
-  detail::object_t* _v;
+  detail::object_node* _v;
 };
 
 class TOUCA_CLIENT_API data_point final {
@@ -190,12 +346,15 @@ class TOUCA_CLIENT_API data_point final {
                                                  const data_point& dst);
   friend TOUCA_CLIENT_API std::map<std::string, data_point> flatten(
       const data_point& input);
+  friend void compare_values(const data_point& src, const data_point& dst,
+                             TypeComparison& cmp);
   friend void to_json(nlohmann::json& out, const data_point& value);
+  friend struct detail::node_access;
 
  public:
   data_point(const array& value)
       : _type(detail::internal_type::array),
-        _array(detail::create<detail::array_t>(*value._v)) {}
+        _array(detail::create<detail::array_node>(*value._v)) {}
 
   data_point(array&& value) noexcept
       : _type(detail::internal_type::array),
@@ -203,13 +362,20 @@ class TOUCA_CLIENT_API data_point final {
 
   data_point(const object& value)
       : _type(detail::internal_type::object),
-        _object(detail::create<detail::object_t>(*value._v)),
-        _name(value.name) {}
+        _object(detail::create<detail::object_node>(*value._v)) {}
 
   data_point(object&& value) noexcept
       : _type(detail::internal_type::object),
-        _object(detail::exchange(value._v, nullptr)),
-        _name(std::move(value.name)) {}
+        _object(detail::exchange(value._v, nullptr)) {}
+
+  data_point(const detail::packed_array_t& value)
+      : _type(detail::internal_type::packed_array),
+        _packed_array(detail::create<detail::packed_array_t>(value)) {}
+
+  data_point(detail::packed_array_t&& value)
+      : _type(detail::internal_type::packed_array),
+        _packed_array(
+            detail::create<detail::packed_array_t>(std::move(value))) {}
 
   data_point(const data_point& other) { init_from_other(other, false); }
   data_point(data_point&& other) noexcept {
@@ -223,7 +389,11 @@ class TOUCA_CLIENT_API data_point final {
   }
 
   data_point& operator=(data_point&& other) noexcept {
-    init_from_other(std::move(other), true);
+    // release our own node first since `other` may hold a different type
+    if (this != &other) {
+      destroy();
+      init_from_other(std::move(other), false);
+    }
     return *this;
   }
 
@@ -260,9 +430,46 @@ class TOUCA_CLIENT_API data_point final {
 
   detail::internal_type type() const noexcept { return _type; }
 
-  detail::array_t* as_array() const noexcept { return _array; }
+  /**
+   * @return elements of this array, or `nullptr` if this data point is
+   *         not an array.
+   */
+  detail::array_t* as_array() const noexcept {
+    return _type == detail::internal_type::array ? &_array->elements
+                                                 : nullptr;
+  }
+
+  detail::object_node* as_object() const noexcept {
+    return _type == detail::internal_type::object ? _object : nullptr;
+  }
+
+  detail::packed_array_t* as_packed_array() const noexcept {
+    return _type == detail::internal_type::packed_array ? _packed_array
+                                                        : nullptr;
+  }
+
+  /**
+   * @brief Structural fingerprint of this data point.
+   *
+   * @details Data points with equal fingerprints compare as identical,
+   *          unless their fingerprint is `detail::unmatched_fingerprint`.
+   *          Like `compare`, fingerprints disregard names of objects and
+   *          whether an array of numbers is packed. Computed from the
+   *          current content of this data point on every call. Along the
+   *          way, fingerprints of nested arrays and objects are cached on
+   *          their nodes, where `compare` looks them up while it visits
+   *          them. Not thread-safe.
+   */
+  detail::fingerprint_t fingerprint() const;
+
+  /**
+   * Converts a packed array into an array of individual data points, so
+   * that elements of any type can be added to it. Has no effect on data
+   * points of other types.
+   */
+  void unpack();
 
-  void increment() noexcept;
+  void increment(const detail::number_unsigned_t count = 1u) noexcept;
   std::string to_string() const;
 
   detail::number_unsigned_t as_metric() const noexcept {
@@ -278,10 +485,10 @@ class TOUCA_CLIENT_API data_point final {
       : _type(detail::internal_type::null), _object(nullptr) {}
 
   // overloads for different types
-  explicit data_point(detail::object_t* obj) noexcept
+  explicit data_point(detail::object_node* obj) noexcept
       : _type(detail::internal_type::object), _object(obj) {}
 
-  explicit data_point(detail::array_t* arr) noexcept
+  explicit data_point(detail::array_node* arr) noexcept
       : _type(detail::internal_type::array), _array(arr) {}
 
   explicit data_point(detail::string_t* str) noexcept
@@ -310,18 +517,27 @@ class TOUCA_CLIENT_API data_point final {
 
   detail::internal_type _type = detail::internal_type::null;
   union {
-    detail::object_t* _object;
-    detail::array_t* _array;
+    detail::object_node* _object;
+    detail::array_node* _array;
     detail::string_t* _string;
+    detail::packed_array_t* _packed_array;
     detail::boolean_t _boolean;
     detail::number_signed_t _number_signed;
     detail::number_unsigned_t _number_unsigned;
     detail::number_float_t _number_float;
     detail::number_double_t _number_double;
   };
-  std::string _name{};
 };
 
+namespace detail {
+
+/**
+ * Results captured in bulk, along with their keys.
+ */
+using result_list = std::vector<std::pair<std::string, data_point>>;
+
+}  // namespace detail
+
 /**
  * @brief Non-specialized template declaration of conversion
  *        logic for handling objects of custom types by the
@@ -410,6 +626,11 @@ struct serializer {
                   "to serialize your value to a Touca type");
     return static_cast<T>(value);
   }
+
+  /**
+   * Moves a data point that is passed by value instead of copying it.
+   */
+  data_point serialize(data_point&& value) { return std::move(value); }
 };
 
 }  // namespace touca
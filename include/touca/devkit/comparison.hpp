@@ -98,6 +98,16 @@ class TOUCA_CLIENT_API TestcaseComparison {
   const Testcase& _dst;
 };
 
+/**
+ * @brief Compares two data points and reports how well they match.
+ *
+ * @details Arrays are compared element by element: each top-level element
+ * counts as one element, nested arrays and objects included, and gets a
+ * score of its own through recursive comparison. The array score is the
+ * sum of these scores divided by the number of elements in the larger
+ * array, and element-wise comparison is skipped when the number of
+ * top-level elements differs by more than 20 percent.
+ */
 TOUCA_CLIENT_API TypeComparison compare(const data_point& src,
                                         const data_point& dst);
 
@@ -2,7 +2,12 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -11,10 +16,19 @@
 namespace touca {
 
 struct Response {
-  Response(const int status, const std::string& body)
-      : status(status), body(body) {}
+  Response(const int status, const std::string& body,
+           const std::string& accept_encoding = "",
+           const std::string& retry_after = "")
+      : status(status),
+        body(body),
+        accept_encoding(accept_encoding),
+        retry_after(retry_after) {}
   const int status = -1;
   const std::string body;
+  /** content codings that the server accepts for request content */
+  const std::string accept_encoding;
+  /** value of the `Retry-After` header, if the server provided one */
+  const std::string retry_after;
 };
 
 class TOUCA_CLIENT_API Transport {
@@ -27,6 +41,38 @@ class TOUCA_CLIENT_API Transport {
                         const std::string& body = "") const = 0;
   virtual Response binary(const std::string& route,
                           const std::string& content) const = 0;
+  /**
+   * Posts binary content that is encoded using a given content coding.
+   *
+   * @param encoding content coding of the given content, such as `gzip`,
+   *                 or an empty string if it is not encoded.
+   */
+  virtual Response binary(const std::string& route, const uint8_t* content,
+                          const std::size_t size,
+                          const std::string& encoding) const {
+    if (!encoding.empty()) {
+      return {-1, "content coding is not supported by this transport"};
+    }
+    return binary(route, std::string(content, content + size));
+  }
+
+  /**
+   * Posts binary content without waiting for the response. Transports
+   * that cannot perform requests concurrently perform the request before
+   * returning.
+   *
+   * @param content binary content that must remain valid until the
+   *                returned future is ready.
+   * @param encoding content coding of the given content, if any.
+   */
+  virtual std::future<Response> binary_async(
+      const std::string& route, const uint8_t* content, const std::size_t size,
+      const std::string& encoding) const {
+    std::promise<Response> response;
+    response.set_value(binary(route, content, size, encoding));
+    return response.get_future();
+  }
+
   virtual ~Transport() = default;
 };
 
@@ -54,6 +100,44 @@ class TOUCA_CLIENT_API ApiUrl {
   std::string _prefix;
 };
 
+/**
+ * Determines how submissions that the server fails to accept are
+ * retried.
+ *
+ * Retries are delayed by a random duration of up to `base_delay`, with
+ * the upper bound doubling after each attempt until it reaches
+ * `max_delay`. If the server asks us to retry after a given number of
+ * seconds, we wait at least that long, or give up if that is longer
+ * than `max_delay`.
+ *
+ * Retries of all submissions made through the same `Platform` draw
+ * from a shared budget of `budget` retries. Each accepted submission
+ * adds a tenth of a retry back to the budget, so that a server that
+ * keeps failing is not flooded with retries of concurrent submissions.
+ */
+struct TOUCA_CLIENT_API RetryPolicy {
+  std::chrono::milliseconds base_delay{250};
+  std::chrono::milliseconds max_delay{30000};
+  unsigned budget = 10u;
+};
+
+/**
+ * Statistics of submissions made through a `Platform`, useful for
+ * logging purposes.
+ */
+struct TOUCA_CLIENT_API SubmitStats {
+  /** number of requests sent to the server, including retries */
+  std::uint64_t requests = 0u;
+  /** number of requests that were retries of a failed request */
+  std::uint64_t retries = 0u;
+  /** number of submissions that we gave up on */
+  std::uint64_t failures = 0u;
+  /** total time spent waiting for the server to respond */
+  std::chrono::milliseconds latency{0};
+  /** longest time spent waiting for the server to respond */
+  std::chrono::milliseconds max_latency{0};
+};
+
 class TOUCA_CLIENT_API Platform {
  public:
   explicit Platform(const ApiUrl& api_url);
@@ -68,6 +152,33 @@ class TOUCA_CLIENT_API Platform {
    */
   bool handshake() const;
 
+  /**
+   * Compresses test results submitted to the server, if the server
+   * accepted compressed content during the most recent handshake.
+   *
+   * @param level compression level between 1 and 9, or 0 to disable
+   *              compression.
+   * @return content coding used for submitting test results, or an
+   *         empty string if test results are submitted uncompressed.
+   */
+  std::string compress(const unsigned level);
+
+  /**
+   * Caches the API token issued by the server and the list of testcases
+   * of the suite in files in the given directory, shared by platforms
+   * that use the same server, team and suite. Cached data is used by
+   * `auth` and `elements` in place of requesting it from the server, for
+   * up to the given number of seconds after it was cached.
+   *
+   * An API token read from the cache that the server no longer accepts
+   * is renewed once, by authenticating again with the same API Key.
+   *
+   * @param dir directory to keep the cache in, or an empty string to
+   *            disable caching.
+   * @param ttl duration for which cached data is used.
+   */
+  void set_cache(const std::string& dir, const std::chrono::seconds ttl);
+
   /**
    * Authenticates with the server using the provided API Key.
    *
@@ -82,13 +193,53 @@ class TOUCA_CLIENT_API Platform {
    * Submits test results in binary format for one or multiple testcases
    * to the server. Expects a valid API Token.
    *
+   * Safe to call from multiple threads at the same time, in which case
+   * each call uses a separate connection to the server. Connections are
+   * kept alive to be reused by subsequent calls.
+   *
+   * Failed requests are retried according to the retry policy.
+   *
    * @param content test results in binary format.
-   * @param max_retries maximum number of retries.
+   * @param max_retries maximum number of attempts.
    * @return a list of error messages useful for logging or printing
    */
   std::vector<std::string> submit(const std::string& content,
                                   const unsigned max_retries) const;
 
+  /**
+   * Submits test results in binary format, provided without copying
+   * them into a string.
+   *
+   * @see submit(const std::string&, const unsigned) const
+   */
+  std::vector<std::string> submit(const uint8_t* content,
+                                  const std::size_t size,
+                                  const unsigned max_retries) const;
+
+  /**
+   * Starts submitting test results in binary format without waiting for
+   * the server to respond, so that multiple submissions can be in flight
+   * at the same time.
+   *
+   * @param content test results that must remain valid until the
+   *                returned future is ready.
+   * @return future list of error messages useful for logging or printing
+   */
+  std::future<std::vector<std::string>> submit_async(
+      const uint8_t* content, const std::size_t size,
+      const unsigned max_retries) const;
+
+  /**
+   * Changes how subsequent submissions are retried, and resets the
+   * budget of retries shared by all submissions.
+   */
+  void set_retry_policy(const RetryPolicy& policy);
+
+  /**
+   * Provides statistics of all submissions made so far.
+   */
+  SubmitStats submit_stats() const;
+
   /**
    * Informs the server that no more testcases will be submitted for
    * the specified revision.
@@ -128,10 +279,52 @@ class TOUCA_CLIENT_API Platform {
   bool cmp_stats(const std::string& content) const;
 
  private:
+  bool signin() const;
+
+  bool renew_token() const;
+
+  /**
+   * Performs a request once more if the server rejected the API token
+   * in its response and we managed to renew the token.
+   */
+  Response reauthorize(const Response& response,
+                       const std::function<Response()>& request) const;
+
+  /**
+   * @return path of the file that caches a given entry. Entries are
+   *         kept in separate files so that processes caching different
+   *         entries at the same time do not overwrite each other.
+   */
+  std::string cache_path(const std::string& entry) const;
+
+  bool next_retry(const Response& response, const unsigned attempt,
+                  std::chrono::milliseconds& delay,
+                  std::string& reason) const;
+
+  void record(const std::chrono::milliseconds latency, const bool retry,
+              const bool accepted) const;
+
   ApiUrl _api;
   std::unique_ptr<Transport> _http;
   bool _is_auth = false;
   mutable std::string _error;
+  // content codings accepted by the server, as of the last handshake
+  mutable std::string _accept_encoding;
+  // content coding and compression level of submitted test results
+  std::string _encoding;
+  unsigned _level = 0u;
+  std::string _api_key;
+  std::string _cache_dir;
+  std::chrono::seconds _cache_ttl{0};
+  mutable std::mutex _token_mutex;
+  // whether the API token was read from the cache and is not renewed yet
+  mutable bool _token_cached = false;
+  mutable bool _token_renewed = false;
+  RetryPolicy _retry_policy;
+  mutable std::mutex _submit_mutex;
+  // retries left in the budget shared by all submissions
+  mutable double _retry_tokens;
+  mutable SubmitStats _submit_stats;
 };
 
 }  // namespace touca
@@ -37,6 +37,18 @@ struct ObjectBuilder;
 struct Array;
 struct ArrayBuilder;
 
+struct IntArray;
+struct IntArrayBuilder;
+
+struct UIntArray;
+struct UIntArrayBuilder;
+
+struct FloatArray;
+struct FloatArrayBuilder;
+
+struct DoubleArray;
+struct DoubleArrayBuilder;
+
 struct Result;
 struct ResultBuilder;
 
@@ -77,8 +89,12 @@ enum class Type : uint8_t {
   String = 6,
   Object = 7,
   Array = 8,
+  IntArray = 9,
+  UIntArray = 10,
+  FloatArray = 11,
+  DoubleArray = 12,
   MIN = NONE,
-  MAX = Array
+  MAX = DoubleArray
 };
 
 bool VerifyType(flatbuffers::Verifier& verifier, const void* obj, Type type);
@@ -475,6 +491,164 @@ struct ArrayBuilder {
   }
 };
 
+struct IntArray FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef IntArrayBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_VALUES = 4
+  };
+  const flatbuffers::Vector<int64_t>* values() const {
+    return GetPointer<const flatbuffers::Vector<int64_t>*>(VT_VALUES);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const {
+    return VerifyTableStart(verifier) && VerifyOffset(verifier, VT_VALUES) &&
+           verifier.VerifyVector(values()) && verifier.EndTable();
+  }
+};
+
+struct IntArrayBuilder {
+  typedef IntArray Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_values(flatbuffers::Offset<flatbuffers::Vector<int64_t>> values) {
+    fbb_.AddOffset(IntArray::VT_VALUES, values);
+  }
+  explicit IntArrayBuilder(flatbuffers::FlatBufferBuilder& _fbb) : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<IntArray> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<IntArray>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<IntArray> CreateIntArray(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    flatbuffers::Offset<flatbuffers::Vector<int64_t>> values = 0) {
+  IntArrayBuilder builder_(_fbb);
+  builder_.add_values(values);
+  return builder_.Finish();
+}
+
+struct UIntArray FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef UIntArrayBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_VALUES = 4
+  };
+  const flatbuffers::Vector<uint64_t>* values() const {
+    return GetPointer<const flatbuffers::Vector<uint64_t>*>(VT_VALUES);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const {
+    return VerifyTableStart(verifier) && VerifyOffset(verifier, VT_VALUES) &&
+           verifier.VerifyVector(values()) && verifier.EndTable();
+  }
+};
+
+struct UIntArrayBuilder {
+  typedef UIntArray Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_values(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> values) {
+    fbb_.AddOffset(UIntArray::VT_VALUES, values);
+  }
+  explicit UIntArrayBuilder(flatbuffers::FlatBufferBuilder& _fbb) : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<UIntArray> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<UIntArray>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<UIntArray> CreateUIntArray(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    flatbuffers::Offset<flatbuffers::Vector<uint64_t>> values = 0) {
+  UIntArrayBuilder builder_(_fbb);
+  builder_.add_values(values);
+  return builder_.Finish();
+}
+
+struct FloatArray FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef FloatArrayBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_VALUES = 4
+  };
+  const flatbuffers::Vector<float>* values() const {
+    return GetPointer<const flatbuffers::Vector<float>*>(VT_VALUES);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const {
+    return VerifyTableStart(verifier) && VerifyOffset(verifier, VT_VALUES) &&
+           verifier.VerifyVector(values()) && verifier.EndTable();
+  }
+};
+
+struct FloatArrayBuilder {
+  typedef FloatArray Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_values(flatbuffers::Offset<flatbuffers::Vector<float>> values) {
+    fbb_.AddOffset(FloatArray::VT_VALUES, values);
+  }
+  explicit FloatArrayBuilder(flatbuffers::FlatBufferBuilder& _fbb)
+      : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<FloatArray> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<FloatArray>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<FloatArray> CreateFloatArray(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    flatbuffers::Offset<flatbuffers::Vector<float>> values = 0) {
+  FloatArrayBuilder builder_(_fbb);
+  builder_.add_values(values);
+  return builder_.Finish();
+}
+
+struct DoubleArray FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef DoubleArrayBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_VALUES = 4
+  };
+  const flatbuffers::Vector<double>* values() const {
+    return GetPointer<const flatbuffers::Vector<double>*>(VT_VALUES);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const {
+    return VerifyTableStart(verifier) && VerifyOffset(verifier, VT_VALUES) &&
+           verifier.VerifyVector(values()) && verifier.EndTable();
+  }
+};
+
+struct DoubleArrayBuilder {
+  typedef DoubleArray Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_values(flatbuffers::Offset<flatbuffers::Vector<double>> values) {
+    fbb_.AddOffset(DoubleArray::VT_VALUES, values);
+  }
+  explicit DoubleArrayBuilder(flatbuffers::FlatBufferBuilder& _fbb)
+      : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<DoubleArray> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<DoubleArray>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<DoubleArray> CreateDoubleArray(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    flatbuffers::Offset<flatbuffers::Vector<double>> values = 0) {
+  DoubleArrayBuilder builder_(_fbb);
+  builder_.add_values(values);
+  return builder_.Finish();
+}
+
 struct Result FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   typedef ResultBuilder Builder;
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
@@ -927,6 +1101,22 @@ inline bool VerifyType(flatbuffers::Verifier& verifier, const void* obj,
       auto ptr = reinterpret_cast<const touca::fbs::Array*>(obj);
       return verifier.VerifyTable(ptr);
     }
+    case Type::IntArray: {
+      auto ptr = reinterpret_cast<const touca::fbs::IntArray*>(obj);
+      return verifier.VerifyTable(ptr);
+    }
+    case Type::UIntArray: {
+      auto ptr = reinterpret_cast<const touca::fbs::UIntArray*>(obj);
+      return verifier.VerifyTable(ptr);
+    }
+    case Type::FloatArray: {
+      auto ptr = reinterpret_cast<const touca::fbs::FloatArray*>(obj);
+      return verifier.VerifyTable(ptr);
+    }
+    case Type::DoubleArray: {
+      auto ptr = reinterpret_cast<const touca::fbs::DoubleArray*>(obj);
+      return verifier.VerifyTable(ptr);
+    }
     default:
       return true;
   }
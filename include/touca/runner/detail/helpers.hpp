@@ -23,6 +23,10 @@ enum Status : uint8_t { Pass, Fail, Skip };
 /**
  * @brief Configures the client based on a given set of configuration options
  *
+ * @details If `options.testcases` is not empty, the client authenticates
+ *          to the server in the background and reports any failure to
+ *          do so once results are posted.
+ *
  * @param options object holding configuration options
  */
 void configure(const ClientOptions& options);
@@ -11,10 +11,25 @@
  *          that users should include in their regression test tool.
  *          It provides all the functions necessary to configure the client,
  *          capture results and submit them to the Touca server.
+ *
+ *          Data capturing functions do not serialize their values
+ *          unless the client is configured and a testcase is declared.
+ *          Defining `TOUCA_DISABLE_CAPTURE` before including this header
+ *          reduces `check`, `assume` and `add_array_element` to no-ops
+ *          that are compiled away, so that production builds may keep
+ *          their instrumentation at no cost.
  */
 
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 
+#include "touca/core/key.hpp"
 #include "touca/core/serializer.hpp"
 #include "touca/extra/logger.hpp"
 #include "touca/lib_api.hpp"
@@ -35,6 +50,14 @@
  */
 namespace touca {
 
+class testcase_handle;
+namespace detail {
+class array_sink;
+class capture_buffer;
+class testcase_entry;
+struct capture_state;
+}  // namespace detail
+
 /**
  * @brief Configures the touca client.
  *
@@ -84,6 +107,48 @@ namespace touca {
  *        to data capturing functions like `check` will affect the newly
  *        declared testcase.
  *
+ * @li @b arena
+ *        Allocates results captured for each testcase from memory
+ *        arenas owned by that testcase, which are released in one step
+ *        when the testcase is forgotten. Reduces the cost of capturing
+ *        large nested structures. Only values serialized by functions
+ *        like `check` are allocated from arenas. Data points passed to
+ *        them that are already built, and values added to a `batch`,
+ *        are allocated on the heap. Defaults to `false`.
+ *
+ * @li @b async-post
+ *        Submits results passed to `post` from a background thread, so
+ *        that `post` does not block on network I/O. Results that could
+ *        not be submitted are reported by `flush` and `seal`.
+ *        Defaults to `false`.
+ *
+ * @li @b post-batch-bytes
+ *        Target size, in bytes, of each request that submits results to
+ *        the server. Testcases are grouped into requests up to this size,
+ *        while larger testcases are submitted on their own.
+ *        Defaults to `4194304`.
+ *
+ * @li @b post-concurrency
+ *        Maximum number of requests, each over a separate connection,
+ *        that `post` may use to submit results at the same time.
+ *        Defaults to `1`.
+ *
+ * @li @b compression-level
+ *        Compresses results submitted to the server in gzip format at
+ *        the given level, from `1` (fastest) to `9` (smallest), if the
+ *        server accepts compressed content. Defaults to `0`, which
+ *        disables compression.
+ *
+ * @li @b cache-dir
+ *        Directory in which the API token issued by the server and the
+ *        list of testcases of the suite are cached, so that processes
+ *        configured shortly after one another do not request them
+ *        again. Disabled by default.
+ *
+ * @li @b cache-ttl
+ *        Number of seconds for which data cached in `cache-dir` is
+ *        used. Defaults to `600`.
+ *
  * The most common pattern for configuring the client is to set
  * configuration parameters `api-url` and `version` as shown below,
  * while providing `TOUCA_API_KEY` as an environment variable.
@@ -221,8 +286,12 @@ TOUCA_CLIENT_API std::vector<std::string> get_testcases();
  *          recent testcase changed to the newly declared one.
  *
  * @param name name of the testcase to be declared
+ *
+ * @return handle to the declared testcase that captures results without
+ *         looking up the most recent testcase of the calling thread.
+ *         The handle is empty if the client is not configured.
  */
-TOUCA_CLIENT_API void declare_testcase(const std::string& name);
+TOUCA_CLIENT_API testcase_handle declare_testcase(const std::string& name);
 
 /**
  * @brief Removes all logged information associated with a given testcase.
@@ -258,12 +327,59 @@ TOUCA_CLIENT_API void forget_testcase(const std::string& name);
  */
 namespace detail {
 
-TOUCA_CLIENT_API void check(const std::string& key, const data_point& value);
+TOUCA_CLIENT_API bool is_capturing();
+
+/**
+ * @return capture buffer of the calling thread for the testcase that it
+ *         captures results for, or `nullptr` if there is no such testcase.
+ */
+TOUCA_CLIENT_API std::shared_ptr<capture_buffer> current_buffer();
+
+/**
+ * @brief Adds results to a given capture buffer.
+ *
+ * @details If the testcase of the buffer allocates its results from an
+ *          arena, keeps the buffer locked and makes its arena the active
+ *          arena of the calling thread for the lifetime of this object,
+ *          so that values serialized in the meantime are allocated from
+ *          that arena and added to the buffer as they are.
+ */
+class TOUCA_CLIENT_API capture_scope {
+ public:
+  explicit capture_scope(std::shared_ptr<capture_buffer> buffer);
 
-TOUCA_CLIENT_API void assume(const std::string& key, const data_point& value);
+  capture_scope(const capture_scope&) = delete;
 
-TOUCA_CLIENT_API void add_array_element(const std::string& key,
-                                        const data_point& value);
+  capture_scope& operator=(const capture_scope&) = delete;
+
+  ~capture_scope();
+
+  explicit operator bool() const { return _buffer != nullptr; }
+
+  void check(const touca::key& key, data_point value);
+
+  void assume(const touca::key& key, data_point value);
+
+  void add_array_element(const touca::key& key, data_point value);
+
+  void add_results(result_list checks, result_list assumptions);
+
+ private:
+  std::shared_ptr<capture_buffer> _buffer;
+  std::unique_lock<std::recursive_mutex> _lock;
+  arena_scope _scope;
+};
+
+TOUCA_CLIENT_API void check(const touca::key& key, data_point value);
+
+TOUCA_CLIENT_API void assume(const touca::key& key, data_point value);
+
+TOUCA_CLIENT_API void add_array_element(const touca::key& key,
+                                        data_point value);
+
+template <typename Value>
+using serializer_for = serializer<
+    typename std::remove_cv<typename std::remove_reference<Value>::type>::type>;
 
 }  // namespace detail
 
@@ -277,8 +393,8 @@ TOUCA_CLIENT_API void add_array_element(const std::string& key,
  *          test results to the declared testcase.
  *
  * @tparam Char type of string to be associated with the value
- *         stored as a result. Expected to be convertible to
- *         `std::basic_string<char>`.
+ *         stored as a result. Expected to be a string literal,
+ *         a `std::string` or a `touca::key`.
  *
  * @tparam Value original type of value `value` to be stored as
  *               a result in association with given key `key`.
@@ -288,8 +404,18 @@ TOUCA_CLIENT_API void add_array_element(const std::string& key,
  * @param value value to be logged as a test result
  */
 template <typename Char, typename Value>
-void check(Char&& key, const Value& value) {
-  detail::check(std::forward<Char>(key), serializer<Value>().serialize(value));
+void check(Char&& key, Value&& value) {
+#ifndef TOUCA_DISABLE_CAPTURE
+  detail::capture_scope scope(detail::current_buffer());
+  if (scope) {
+    scope.check(std::forward<Char>(key),
+                detail::serializer_for<Value>().serialize(
+                    std::forward<Value>(value)));
+  }
+#else
+  (void)key;
+  (void)value;
+#endif
 }
 
 /**
@@ -307,8 +433,8 @@ void check(Char&& key, const Value& value) {
  *          assumptions about input data and their properties.
  *
  * @tparam Char type of string to be associated with the value
- *         stored as an assumption. Expected to be convertible to
- *         `std::basic_string<char>`.
+ *         stored as an assumption. Expected to be a string literal,
+ *         a `std::string` or a `touca::key`.
  *
  * @tparam Value original type of value `value` to be stored as
  *               an assumption in association with given key `key`.
@@ -320,8 +446,18 @@ void check(Char&& key, const Value& value) {
  * @see check
  */
 template <typename Char, typename Value>
-void assume(Char&& key, const Value& value) {
-  detail::assume(std::forward<Char>(key), serializer<Value>().serialize(value));
+void assume(Char&& key, Value&& value) {
+#ifndef TOUCA_DISABLE_CAPTURE
+  detail::capture_scope scope(detail::current_buffer());
+  if (scope) {
+    scope.assume(std::forward<Char>(key),
+                 detail::serializer_for<Value>().serialize(
+                     std::forward<Value>(value)));
+  }
+#else
+  (void)key;
+  (void)value;
+#endif
 }
 
 /**
@@ -362,8 +498,8 @@ void assume(Char&& key, const Value& value) {
  *          @endcode
  *
  * @tparam Char type of string to be associated with the value
- *         stored as an element. Expected to be convertible to
- *         `std::basic_string<char>`.
+ *         stored as an element. Expected to be a string literal,
+ *         a `std::string` or a `touca::key`.
  *
  * @tparam Value original type of value `value` to be stored as
  *               an element of an array associated with given key `key`.
@@ -381,9 +517,163 @@ void assume(Char&& key, const Value& value) {
  * @since v1.1
  */
 template <typename Char, typename Value>
-void add_array_element(Char&& key, const Value& value) {
-  detail::add_array_element(std::forward<Char>(key),
-                            serializer<Value>().serialize(value));
+void add_array_element(Char&& key, Value&& value) {
+#ifndef TOUCA_DISABLE_CAPTURE
+  detail::capture_scope scope(detail::current_buffer());
+  if (scope) {
+    scope.add_array_element(std::forward<Char>(key),
+                            detail::serializer_for<Value>().serialize(
+                                std::forward<Value>(value)));
+  }
+#else
+  (void)key;
+  (void)value;
+#endif
+}
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace detail {
+
+TOUCA_CLIENT_API void add_results(result_list checks, result_list assumptions);
+
+}  // namespace detail
+
+#endif  // DOXYGEN_SHOULD_SKIP_THIS
+
+/**
+ * @brief Collects results to be added to the declared testcase in one
+ *        step via `check_many`.
+ *
+ * @details Useful for workflows that capture many results at once.
+ *          Values are serialized as they are added to the batch, but
+ *          the declared testcase is looked up only once, when the batch
+ *          is submitted. Values are not serialized if no testcase was
+ *          declared when the batch was created.
+ *
+ *          @code
+ *              touca::batch results;
+ *              results.check("width", image.width())
+ *                  .check("height", image.height())
+ *                  .assume("format", image.format());
+ *              touca::check_many(std::move(results));
+ *          @endcode
+ */
+class batch {
+ public:
+#ifndef TOUCA_DISABLE_CAPTURE
+  batch() : _enabled(detail::is_capturing()) {}
+#else
+  batch() = default;
+#endif
+
+  /** @see touca::check */
+  template <typename Value>
+  batch& check(const touca::key& key, Value&& value) {
+#ifndef TOUCA_DISABLE_CAPTURE
+    if (_enabled) {
+      _checks.emplace_back(
+          key.str(), detail::serializer_for<Value>().serialize(
+                         std::forward<Value>(value)));
+    }
+#else
+    (void)key;
+    (void)value;
+#endif
+    return *this;
+  }
+
+  /** @see touca::assume */
+  template <typename Value>
+  batch& assume(const touca::key& key, Value&& value) {
+#ifndef TOUCA_DISABLE_CAPTURE
+    if (_enabled) {
+      _assumptions.emplace_back(
+          key.str(), detail::serializer_for<Value>().serialize(
+                         std::forward<Value>(value)));
+    }
+#else
+    (void)key;
+    (void)value;
+#endif
+    return *this;
+  }
+
+  /**
+   * Reserves space for a given number of checks.
+   */
+  void reserve(const std::size_t count) { _checks.reserve(count); }
+
+  std::size_t size() const { return _checks.size() + _assumptions.size(); }
+
+ private:
+  friend void check_many(batch&& results);
+
+#ifndef TOUCA_DISABLE_CAPTURE
+  bool _enabled;
+#endif
+  detail::result_list _checks;
+  detail::result_list _assumptions;
+};
+
+/**
+ * @brief Adds all results collected in a given batch to the declared
+ *        testcase.
+ *
+ * @details Equivalent to calling `check` and `assume` for each result in
+ *          the batch, except that the testcase is looked up, and its
+ *          results are synchronized with other threads, only once.
+ *
+ * @param results batch of results to be added
+ */
+inline void check_many(batch&& results) {
+#ifndef TOUCA_DISABLE_CAPTURE
+  if (results.size() != 0u) {
+    detail::add_results(std::move(results._checks),
+                        std::move(results._assumptions));
+  }
+#else
+  (void)results;
+#endif
+}
+
+/**
+ * @brief Logs each value in a given collection of key-value pairs as a
+ *        test result for the declared testcase.
+ *
+ * @details Same as calling `check` for each pair in the collection,
+ *          except that the testcase is looked up only once.
+ *
+ *          @code
+ *              std::map<std::string, double> scores = compute_scores();
+ *              touca::check_many(scores);
+ *          @endcode
+ *
+ * @tparam Results iterable of pairs whose first element is convertible
+ *         to `std::string`, such as `std::map` or a vector of pairs.
+ *
+ * @param results collection of key-value pairs to be logged
+ */
+template <typename Results,
+          typename = detail::enable_if_t<detail::is_iterable<Results>::value>>
+void check_many(const Results& results) {
+#ifndef TOUCA_DISABLE_CAPTURE
+  detail::capture_scope scope(detail::current_buffer());
+  if (!scope) {
+    return;
+  }
+  detail::result_list checks;
+  checks.reserve(std::distance(std::begin(results), std::end(results)));
+  for (const auto& result : results) {
+    checks.emplace_back(
+        result.first,
+        detail::serializer_for<decltype(result.second)>().serialize(
+            result.second));
+  }
+  scope.add_results(std::move(checks), {});
+#else
+  (void)results;
+#endif
 }
 
 /**
@@ -424,7 +714,203 @@ void add_array_element(Char&& key, const Value& value) {
  *
  * @since v1.1
  */
-TOUCA_CLIENT_API void add_hit_count(const std::string& key);
+TOUCA_CLIENT_API void add_hit_count(const touca::key& key);
+
+/**
+ * @brief Counts hits of a given key for a specific testcase at the cost
+ *        of an atomic increment.
+ *
+ * @details Obtained via `make_counter` or `testcase_handle::make_counter`.
+ *          Unlike `add_hit_count`, incrementing a counter does not look
+ *          up the testcase or the result associated with its key, which
+ *          makes counters suitable for hot loops. Hits are added to the
+ *          result of the key when the testcase is saved or posted.
+ *          Counters are safe to share between threads. Incrementing an
+ *          empty counter is a no-op.
+ *
+ *          @code
+ *              auto hits = touca::make_counter("cache hits");
+ *              for (const auto& request : requests) {
+ *                if (cache.contains(request)) {
+ *                  hits.increment();
+ *                }
+ *              }
+ *          @endcode
+ */
+class hit_counter {
+ public:
+  hit_counter() = default;
+
+  explicit hit_counter(std::shared_ptr<std::atomic<std::uint64_t>> count)
+      : _count(std::move(count)) {}
+
+  explicit operator bool() const { return _count != nullptr; }
+
+  void increment(const std::uint64_t count = 1u) {
+    if (_count) {
+      _count->fetch_add(count, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  std::shared_ptr<std::atomic<std::uint64_t>> _count;
+};
+
+/**
+ * @brief Creates a counter of hits of a given key for the testcase that
+ *        the calling thread currently captures results for.
+ *
+ * @details The counter keeps counting hits for that testcase even if a
+ *          different testcase is declared afterwards.
+ *
+ * @param key name to be associated with the logged test result.
+ *
+ * @return counter of hits of the given key, or an empty counter if the
+ *         calling thread does not capture results for any testcase.
+ *
+ * @see add_hit_count
+ */
+TOUCA_CLIENT_API hit_counter make_counter(const touca::key& key);
+
+/**
+ * @brief Appends elements to an array result of a specific testcase.
+ *
+ * @details Obtained via `make_appender` or `testcase_handle::make_appender`.
+ *          Unlike `add_array_element`, appending an element does not
+ *          look up the testcase or the result associated with its key.
+ *          Elements are stored in fixed-size chunks that are spliced
+ *          into the result of the key when the testcase is saved or
+ *          posted, so appending never copies previous elements. Appending
+ *          to an empty appender is a no-op.
+ *
+ *          @code
+ *              auto latencies = touca::make_appender("latencies");
+ *              for (const auto& request : requests) {
+ *                latencies.add(handle(request));
+ *              }
+ *          @endcode
+ *
+ * @see packed_appender for arrays of numbers
+ */
+class TOUCA_CLIENT_API array_appender {
+ public:
+  array_appender() = default;
+
+  explicit array_appender(std::shared_ptr<detail::array_sink> sink);
+
+  explicit operator bool() const { return _sink != nullptr; }
+
+  /** @see touca::add_array_element */
+  template <typename Value>
+  void add(Value&& value) {
+#ifndef TOUCA_DISABLE_CAPTURE
+    if (_sink) {
+      add_value(detail::serializer_for<Value>().serialize(
+          std::forward<Value>(value)));
+    }
+#else
+    (void)value;
+#endif
+  }
+
+ private:
+  void add_value(data_point value);
+
+  std::shared_ptr<detail::array_sink> _sink;
+};
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace detail {
+
+TOUCA_CLIENT_API void append(array_sink& sink, const number_signed_t value);
+
+TOUCA_CLIENT_API void append(array_sink& sink, const number_unsigned_t value);
+
+TOUCA_CLIENT_API void append(array_sink& sink, const number_float_t value);
+
+TOUCA_CLIENT_API void append(array_sink& sink, const number_double_t value);
+
+}  // namespace detail
+
+#endif  // DOXYGEN_SHOULD_SKIP_THIS
+
+/**
+ * @brief Appends numbers of type `T` to an array result of a specific
+ *        testcase, stored as a packed array of numbers.
+ *
+ * @details Same as `array_appender` except that numbers are stored
+ *          contiguously, rather than as individual data points.
+ *
+ * @tparam T one of `int64_t`, `uint64_t`, `float` or `double`
+ */
+template <typename T>
+class packed_appender {
+ public:
+  using element_type = T;
+
+  packed_appender() = default;
+
+  explicit packed_appender(std::shared_ptr<detail::array_sink> sink)
+      : _sink(std::move(sink)) {}
+
+  explicit operator bool() const { return _sink != nullptr; }
+
+  void add(const T value) {
+#ifndef TOUCA_DISABLE_CAPTURE
+    if (_sink) {
+      detail::append(*_sink, value);
+    }
+#else
+    (void)value;
+#endif
+  }
+
+ private:
+  std::shared_ptr<detail::array_sink> _sink;
+};
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace detail {
+
+TOUCA_CLIENT_API std::shared_ptr<array_sink> make_sink(
+    const touca::key& key, const internal_type element_type);
+
+}  // namespace detail
+
+#endif  // DOXYGEN_SHOULD_SKIP_THIS
+
+/**
+ * @brief Creates an appender of elements to the array result of a given
+ *        key for the testcase that the calling thread currently captures
+ *        results for.
+ *
+ * @details The appender keeps appending elements for that testcase even
+ *          if a different testcase is declared afterwards. Appenders
+ *          should not be shared between threads.
+ *
+ * @param key name to be associated with the logged test result.
+ *
+ * @return appender to the array result of the given key, or an empty
+ *         appender if the calling thread does not capture results for
+ *         any testcase.
+ *
+ * @see add_array_element
+ */
+TOUCA_CLIENT_API array_appender make_appender(const touca::key& key);
+
+/**
+ * @brief Same as `make_appender` except that elements are numbers of
+ *        type `T` stored as a packed array.
+ *
+ * @tparam T one of `int64_t`, `uint64_t`, `float` or `double`
+ */
+template <typename T>
+packed_appender<T> make_packed_appender(const touca::key& key) {
+  return packed_appender<T>(
+      detail::make_sink(key, detail::packed_traits<T>::type));
+}
 
 /**
  * @brief adds an already obtained performance measurements.
@@ -465,6 +951,253 @@ TOUCA_CLIENT_API void start_timer(const std::string& key);
  */
 TOUCA_CLIENT_API void stop_timer(const std::string& key);
 
+/**
+ * @brief Captures results for a specific testcase.
+ *
+ * @details Returned by `declare_testcase`. Behaves like the free data
+ *          capturing functions except that results are always added to
+ *          the testcase that this handle refers to, which spares hot
+ *          loops the lookup of the most recent testcase of the calling
+ *          thread. Calls on an empty handle are no-ops. Results are
+ *          added to the capture buffer of the thread that created the
+ *          handle, so a handle is best used by that thread. Results
+ *          captured through a handle of a forgotten testcase are
+ *          discarded.
+ *
+ *          @code
+ *              auto testcase = touca::declare_testcase("some-case");
+ *              for (const auto& item : items) {
+ *                testcase.add_array_element("items", item);
+ *                testcase.add_hit_count("item count");
+ *              }
+ *          @endcode
+ */
+class TOUCA_CLIENT_API testcase_handle {
+ public:
+  testcase_handle() = default;
+
+  explicit testcase_handle(std::shared_ptr<detail::testcase_entry> entry);
+
+  explicit operator bool() const { return _entry != nullptr; }
+
+  /** @see touca::check */
+  template <typename Char, typename Value>
+  void check(Char&& key, Value&& value) {
+#ifndef TOUCA_DISABLE_CAPTURE
+    if (_entry) {
+      detail::capture_scope scope(_buffer);
+      scope.check(std::forward<Char>(key),
+                  detail::serializer_for<Value>().serialize(
+                      std::forward<Value>(value)));
+    }
+#else
+    (void)key;
+    (void)value;
+#endif
+  }
+
+  /** @see touca::assume */
+  template <typename Char, typename Value>
+  void assume(Char&& key, Value&& value) {
+#ifndef TOUCA_DISABLE_CAPTURE
+    if (_entry) {
+      detail::capture_scope scope(_buffer);
+      scope.assume(std::forward<Char>(key),
+                   detail::serializer_for<Value>().serialize(
+                       std::forward<Value>(value)));
+    }
+#else
+    (void)key;
+    (void)value;
+#endif
+  }
+
+  /** @see touca::add_array_element */
+  template <typename Char, typename Value>
+  void add_array_element(Char&& key, Value&& value) {
+#ifndef TOUCA_DISABLE_CAPTURE
+    if (_entry) {
+      detail::capture_scope scope(_buffer);
+      scope.add_array_element(std::forward<Char>(key),
+                              detail::serializer_for<Value>().serialize(
+                                  std::forward<Value>(value)));
+    }
+#else
+    (void)key;
+    (void)value;
+#endif
+  }
+
+  /** @see touca::add_hit_count */
+  void add_hit_count(const touca::key& key);
+
+  /** @see touca::make_counter */
+  hit_counter make_counter(const touca::key& key);
+
+  /** @see touca::make_appender */
+  array_appender make_appender(const touca::key& key);
+
+  /** @see touca::make_packed_appender */
+  template <typename T>
+  packed_appender<T> make_packed_appender(const touca::key& key) {
+    return packed_appender<T>(make_sink(key, detail::packed_traits<T>::type));
+  }
+
+  /** @see touca::add_metric */
+  void add_metric(const std::string& key, const unsigned duration);
+
+  /** @see touca::start_timer */
+  void start_timer(const std::string& key);
+
+  /** @see touca::stop_timer */
+  void stop_timer(const std::string& key);
+
+ private:
+  std::shared_ptr<detail::array_sink> make_sink(
+      const touca::key& key, const detail::internal_type element_type);
+
+  std::shared_ptr<detail::testcase_entry> _entry;
+  std::shared_ptr<detail::capture_buffer> _buffer;
+};
+
+/**
+ * @brief Refers to the testcase that the calling thread captures results
+ *        for, so that it can be reinstalled on another thread.
+ *
+ * @details The testcase of a thread is determined by the testcases that
+ *          it, or in shared mode any other thread, declared. Tasks that
+ *          hop across threads of an executor, or coroutines that resume
+ *          on a different thread, lose track of their testcase. Such
+ *          tasks may obtain the context of their testcase before they
+ *          are submitted and install it via `context_scope` once they
+ *          run. Contexts are cheap to copy.
+ *
+ *          @code
+ *              auto context = touca::testcase_context::current();
+ *              pool.submit([context]() {
+ *                touca::context_scope scope(context);
+ *                touca::check("some-key", some_value);
+ *              });
+ *          @endcode
+ *
+ * @see bind_context
+ */
+class TOUCA_CLIENT_API testcase_context {
+ public:
+  /**
+   * Creates a context that refers to no testcase. Installing it
+   * disables capturing results.
+   */
+  testcase_context() = default;
+
+  /**
+   * @return context of the testcase that the calling thread captures
+   *         results for
+   */
+  static testcase_context current();
+
+  explicit operator bool() const { return _entry != nullptr; }
+
+ private:
+  friend class context_scope;
+
+  explicit testcase_context(std::shared_ptr<detail::testcase_entry> entry);
+
+  std::shared_ptr<detail::testcase_entry> _entry;
+};
+
+/**
+ * @brief Makes the calling thread capture results for the testcase of a
+ *        given context until this object goes out of scope.
+ *
+ * @details While a scope is active, testcases declared by other threads
+ *          do not change the testcase of the calling thread, even if
+ *          configuration option `single-thread` is not set. Scopes may
+ *          be nested and restore the previous testcase of the calling
+ *          thread when destroyed. A scope should be destroyed by the
+ *          thread that created it.
+ */
+class TOUCA_CLIENT_API context_scope {
+ public:
+  explicit context_scope(const testcase_context& context);
+
+  ~context_scope();
+
+  context_scope(const context_scope&) = delete;
+
+  context_scope& operator=(const context_scope&) = delete;
+
+ private:
+  std::unique_ptr<detail::capture_state> _previous;
+};
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+
+namespace detail {
+
+/**
+ * Callable that invokes a given function within a context scope.
+ */
+template <typename Func>
+class context_task {
+ public:
+  context_task(testcase_context context, Func func)
+      : _context(std::move(context)), _func(std::move(func)) {}
+
+  template <typename... Args>
+  auto operator()(Args&&... args)
+      -> decltype(std::declval<Func&>()(std::forward<Args>(args)...)) {
+    context_scope scope(_context);
+    return _func(std::forward<Args>(args)...);
+  }
+
+ private:
+  testcase_context _context;
+  Func _func;
+};
+
+}  // namespace detail
+
+#endif  // DOXYGEN_SHOULD_SKIP_THIS
+
+/**
+ * @brief Wraps a given function so that it captures results for the
+ *        current testcase of the calling thread, on whichever thread it
+ *        is eventually invoked.
+ *
+ * @details Useful for submitting tasks to thread pools and executors:
+ *          @code
+ *              pool.submit(touca::bind_context([]() {
+ *                touca::add_hit_count("tasks");
+ *              }));
+ *          @endcode
+ *
+ * @param func function to be wrapped
+ *
+ * @return callable that installs the context of the current testcase
+ *         while invoking `func`
+ */
+template <typename Func>
+detail::context_task<typename std::decay<Func>::type> bind_context(
+    Func&& func) {
+  return detail::context_task<typename std::decay<Func>::type>(
+      testcase_context::current(), std::forward<Func>(func));
+}
+
+/**
+ * @brief Same as `std::async` except that the given function captures
+ *        results for the current testcase of the calling thread.
+ *
+ * @see bind_context
+ */
+template <typename Func, typename... Args>
+auto async(std::launch policy, Func&& func, Args&&... args)
+    -> decltype(std::async(policy, bind_context(std::forward<Func>(func)),
+                           std::forward<Args>(args)...)) {
+  return std::async(policy, bind_context(std::forward<Func>(func)),
+                    std::forward<Args>(args)...);
+}
+
 /**
  * @brief Stores testresults in binary format in a file of specified path.
  *
@@ -529,13 +1262,33 @@ TOUCA_CLIENT_API void save_json(const std::string& path,
  *          to touca::post() will resubmit the modified
  *          testcase.
  *
- * @return true if all testresults are successfully posted to the server.
+ *          If configuration parameter `async-post` is set, testresults
+ *          are serialized and placed in a bounded queue to be submitted
+ *          by a background thread. In that case, this function only
+ *          blocks while the queue is full and the outcome of the
+ *          submission is reported by `flush`. Testcases may be changed
+ *          or forgotten once this function returns.
+ *
+ * @return true if all testresults are successfully posted to the server,
+ *         or queued for submission.
  *
  * @throw runtime_error if configuration parameter `api-url` is
  *        not provided during configuration operation.
  */
 TOUCA_CLIENT_API bool post();
 
+/**
+ * @brief Waits until testresults posted in the background are submitted
+ *        to the Touca server.
+ *
+ * @details Has no effect unless configuration parameter `async-post` is
+ *          set. Called by `seal` before sealing the version.
+ *
+ * @return false if any testresults posted in the background since the
+ *         previous call to this function could not be submitted.
+ */
+TOUCA_CLIENT_API bool flush();
+
 /**
  * @brief Notifies Touca server that all test cases were executed
  *        and no further test result is expected to be submitted.
@@ -543,6 +1296,10 @@ TOUCA_CLIENT_API bool post();
  * @details Expected to be called by the test tool once all test cases
  *          are executed and all test results are posted.
  *
+ *          Blocks until testresults posted in the background, if any,
+ *          are submitted. The version is not sealed if some of them
+ *          could not be submitted.
+ *
  *          Sealing the version is optional. The Touca server automatically
  *          performs this operation once a certain amount of time has
  *          passed since the last test case was submitted. This duration
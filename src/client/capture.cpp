@@ -0,0 +1,457 @@
+// Copyright 2021 Touca, Inc. Subject to Apache-2.0 License.
+
+#include "touca/client/detail/capture.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include "touca/core/arena.hpp"
+#include "touca/touca.hpp"
+
+namespace touca {
+namespace detail {
+
+capture_buffer::capture_buffer(const Testcase::Metadata& meta,
+                               const bool arena)
+    : _results(meta.teamslug, meta.testsuite, meta.version, meta.testcase,
+               arena),
+      _arena(_results._arena) {}
+
+void capture_buffer::check(const touca::key& key, data_point value) {
+  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  _results.check(key, std::move(value));
+}
+
+void capture_buffer::assume(const touca::key& key, data_point value) {
+  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  _results.assume(key, std::move(value));
+}
+
+void capture_buffer::add_results(detail::result_list checks,
+                                 detail::result_list assumptions) {
+  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  _results.add_results(std::move(checks), ResultCategory::Check);
+  _results.add_results(std::move(assumptions), ResultCategory::Assert);
+}
+
+void capture_buffer::add_array_element(const touca::key& key,
+                                       data_point value) {
+  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  _results.add_array_element(key, std::move(value));
+  _accumulated.insert(key.hash());
+}
+
+void capture_buffer::add_hit_count(const touca::key& key) {
+  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  _results.add_hit_count(key);
+  _accumulated.insert(key.hash());
+}
+
+template <typename T>
+static void rehome_values(packed_array_t& packed) {
+  auto& values = packed_traits<T>::values(packed);
+  packed_values_t<T> copy(values.begin(), values.end());
+  values.swap(copy);
+}
+
+/**
+ * Moves the elements of a given array result into storage allocated from
+ * the active arena. Array results of a testcase grow as other buffers
+ * are merged into it, which should not allocate from the arena of the
+ * buffer that captured them while its thread may still be using it.
+ */
+static void rehome(data_point& value) {
+  if (value.type() == internal_type::array) {
+    auto& elements = *value.as_array();
+    array_t copy(std::make_move_iterator(elements.begin()),
+                 std::make_move_iterator(elements.end()));
+    elements.swap(copy);
+  } else if (value.type() == internal_type::packed_array) {
+    auto& packed = *value.as_packed_array();
+    switch (packed.element_type) {
+      case internal_type::number_signed:
+        rehome_values<number_signed_t>(packed);
+        break;
+      case internal_type::number_unsigned:
+        rehome_values<number_unsigned_t>(packed);
+        break;
+      case internal_type::number_float:
+        rehome_values<number_float_t>(packed);
+        break;
+      default:
+        rehome_values<number_double_t>(packed);
+        break;
+    }
+  }
+}
+
+std::vector<std::string> capture_buffer::merge_into(Testcase& testcase) {
+  std::lock_guard<std::recursive_mutex> lock(_mutex);
+  std::vector<std::string> dropped;
+  if (_results._resultsMap.empty()) {
+    return dropped;
+  }
+  arena_scope scope(testcase._arena.get());
+  for (auto& result : _results._resultsMap) {
+    const touca::key key(result.first);
+    auto slot = testcase.find_result(key);
+    if (!slot.found) {
+      if (_arena) {
+        rehome(result.second.val);
+      }
+      testcase.insert_result(slot, std::move(result.second));
+      continue;
+    }
+    // like `check`, keep the value that the testcase already has unless
+    // the result is meant to be accumulated.
+    if (!_accumulated.count(key.hash())) {
+      continue;
+    }
+    auto& src = result.second.val;
+    auto& dst = slot.it->second.val;
+    src.unpack();
+    dst.unpack();
+    if (src.type() == internal_type::array &&
+        dst.type() == internal_type::array) {
+      auto& elements = *dst.as_array();
+      for (auto& element : *src.as_array()) {
+        elements.push_back(std::move(element));
+      }
+    } else if (src.type() == internal_type::number_unsigned &&
+               dst.type() == internal_type::number_unsigned) {
+      dst.increment(src.as_metric());
+    } else {
+      dropped.push_back(result.first);
+    }
+  }
+  testcase.invalidate();
+  // nodes moved into the testcase are still allocated from our arena.
+  // we keep using the same arena, rather than clearing our results, so
+  // that our thread never shares an arena with the testcase.
+  if (_arena && std::find(testcase._adopted.begin(), testcase._adopted.end(),
+                          _arena) == testcase._adopted.end()) {
+    testcase._adopted.push_back(_arena);
+  }
+  _results._keyIndex.entries.clear();
+  _results._resultsMap.clear();
+  _accumulated.clear();
+  return dropped;
+}
+
+capture_scope::capture_scope(std::shared_ptr<capture_buffer> buffer)
+    : _buffer(std::move(buffer)),
+      _lock(_buffer && _buffer->_arena
+                ? std::unique_lock<std::recursive_mutex>(_buffer->_mutex)
+                : std::unique_lock<std::recursive_mutex>()),
+      _scope(_lock ? _buffer->_arena.get() : active_arena()) {}
+
+capture_scope::~capture_scope() = default;
+
+void capture_scope::check(const touca::key& key, data_point value) {
+  _buffer->check(key, std::move(value));
+}
+
+void capture_scope::assume(const touca::key& key, data_point value) {
+  _buffer->assume(key, std::move(value));
+}
+
+void capture_scope::add_array_element(const touca::key& key,
+                                      data_point value) {
+  _buffer->add_array_element(key, std::move(value));
+}
+
+void capture_scope::add_results(result_list checks,
+                                result_list assumptions) {
+  _buffer->add_results(std::move(checks), std::move(assumptions));
+}
+
+/** maximum number of elements in each chunk of an array sink */
+constexpr std::size_t sink_chunk_size = 4096;
+
+template <typename T>
+static void append_values(const packed_array_t& src, packed_array_t& dst) {
+  const auto& values = packed_traits<T>::values(src);
+  auto& elements = packed_traits<T>::values(dst);
+  elements.insert(elements.end(), values.begin(), values.end());
+}
+
+static void reserve_values(packed_array_t& dst, const std::size_t count) {
+  switch (dst.element_type) {
+    case internal_type::number_signed:
+      dst.signed_values.reserve(count);
+      break;
+    case internal_type::number_unsigned:
+      dst.unsigned_values.reserve(count);
+      break;
+    case internal_type::number_float:
+      dst.float_values.reserve(count);
+      break;
+    default:
+      dst.double_values.reserve(count);
+      break;
+  }
+}
+
+static std::size_t chunk_size(const data_point& chunk) {
+  const auto packed = chunk.as_packed_array();
+  return packed ? packed->size() : chunk.as_array()->size();
+}
+
+array_sink::array_sink(const internal_type element_type)
+    : _element_type(element_type) {}
+
+data_point& array_sink::chunk() {
+  if (!_chunks.empty()) {
+    const auto& last = _chunks.back();
+    const auto size = _element_type == internal_type::array
+                          ? last.as_array()->size()
+                          : last.as_packed_array()->size();
+    if (size < sink_chunk_size) {
+      return _chunks.back();
+    }
+  }
+  // chunks are allocated on the heap, regardless of the arena of their
+  // testcase, since the sink may outlive the testcase.
+  arena_scope scope(nullptr);
+  if (_element_type == internal_type::array) {
+    array_t elements;
+    elements.reserve(sink_chunk_size);
+    _chunks.emplace_back(array());
+    _chunks.back().as_array()->swap(elements);
+  } else {
+    _chunks.emplace_back(packed_array_t(_element_type));
+  }
+  return _chunks.back();
+}
+
+void array_sink::append(data_point value) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  chunk().as_array()->push_back(std::move(value));
+}
+
+template <typename T>
+void array_sink::append_packed(const T value) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& elements = packed_traits<T>::values(*chunk().as_packed_array());
+  if (elements.empty()) {
+    elements.reserve(sink_chunk_size);
+  }
+  elements.push_back(value);
+}
+
+void array_sink::append(const number_signed_t value) { append_packed(value); }
+
+void array_sink::append(const number_unsigned_t value) {
+  append_packed(value);
+}
+
+void array_sink::append(const number_float_t value) { append_packed(value); }
+
+void array_sink::append(const number_double_t value) { append_packed(value); }
+
+bool array_sink::merge_into(Testcase& testcase, const std::string& name) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_chunks.empty()) {
+    return true;
+  }
+  auto merged = true;
+  arena_scope scope(testcase._arena.get());
+  const touca::key key(name);
+  // number of elements in chunks not merged yet, so that the result
+  // grows once to hold all of them rather than once per chunk.
+  std::size_t remaining = 0u;
+  for (const auto& chunk : _chunks) {
+    remaining += chunk_size(chunk);
+  }
+  auto reserved = false;
+  for (auto& chunk : _chunks) {
+    const auto count = chunk_size(chunk);
+    auto slot = testcase.find_result(key);
+    if (!slot.found) {
+      testcase.insert_result(
+          slot, ResultEntry{std::move(chunk), ResultCategory::Check});
+      remaining -= count;
+      continue;
+    }
+    auto& dst = slot.it->second.val;
+    const auto packed = dst.as_packed_array();
+    if (packed && packed->element_type == _element_type) {
+      if (!reserved) {
+        reserve_values(*packed, packed->size() + remaining);
+        reserved = true;
+      }
+      remaining -= count;
+      const auto& src = *chunk.as_packed_array();
+      switch (_element_type) {
+        case internal_type::number_signed:
+          append_values<number_signed_t>(src, *packed);
+          break;
+        case internal_type::number_unsigned:
+          append_values<number_unsigned_t>(src, *packed);
+          break;
+        case internal_type::number_float:
+          append_values<number_float_t>(src, *packed);
+          break;
+        default:
+          append_values<number_double_t>(src, *packed);
+          break;
+      }
+      continue;
+    }
+    remaining -= count;
+    dst.unpack();
+    chunk.unpack();
+    if (dst.type() != internal_type::array) {
+      merged = false;
+      continue;
+    }
+    auto& elements = *dst.as_array();
+    if (!reserved) {
+      elements.reserve(elements.size() + count + remaining);
+      reserved = true;
+    }
+    for (auto& element : *chunk.as_array()) {
+      elements.push_back(std::move(element));
+    }
+  }
+  _chunks.clear();
+  testcase.invalidate();
+  return merged;
+}
+
+testcase_entry::testcase_entry(std::shared_ptr<Testcase> testcase,
+                               const bool arena)
+    : _testcase(std::move(testcase)), _forgotten(false), _arena(arena) {}
+
+std::shared_ptr<capture_buffer> testcase_entry::buffer() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& buffer = _buffers[std::this_thread::get_id()];
+  if (!buffer) {
+    buffer = std::make_shared<capture_buffer>(_testcase->metadata(), _arena);
+  }
+  return buffer;
+}
+
+void testcase_entry::tic(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _testcase->tic(key);
+}
+
+void testcase_entry::toc(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _testcase->toc(key);
+}
+
+std::shared_ptr<std::atomic<std::uint64_t>> testcase_entry::counter(
+    const touca::key& key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& counter = _counters[key.str()];
+  if (!counter) {
+    counter = std::make_shared<std::atomic<std::uint64_t>>(0u);
+  }
+  return counter;
+}
+
+std::shared_ptr<array_sink> testcase_entry::sink(
+    const touca::key& key, const internal_type element_type) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto sink = std::make_shared<array_sink>(element_type);
+  _sinks.emplace_back(key.str(), sink);
+  return sink;
+}
+
+std::vector<std::string> testcase_entry::flush() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<std::string> dropped;
+  for (auto it = _buffers.begin(); it != _buffers.end();) {
+    const auto& keys = it->second->merge_into(*_testcase);
+    dropped.insert(dropped.end(), keys.begin(), keys.end());
+    // buffers that are no longer used by any thread are released
+    it = it->second.use_count() == 1 ? _buffers.erase(it) : std::next(it);
+  }
+  for (auto it = _sinks.begin(); it != _sinks.end();) {
+    if (!it->second->merge_into(*_testcase, it->first)) {
+      dropped.push_back(it->first);
+    }
+    // sinks whose appenders are all destroyed are released
+    it = it->second.use_count() == 1 ? _sinks.erase(it) : std::next(it);
+  }
+  for (const auto& counter : _counters) {
+    const auto count = counter.second->exchange(0u, std::memory_order_relaxed);
+    if (count == 0u) {
+      continue;
+    }
+    try {
+      _testcase->add_hit_count(counter.first, count);
+    } catch (const std::invalid_argument&) {
+      dropped.push_back(counter.first);
+    }
+  }
+  return dropped;
+}
+
+void testcase_entry::apply(const std::function<void(Testcase&)>& func) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  func(*_testcase);
+}
+
+testcase_registry::shard& testcase_registry::shard_of(
+    const std::string& name) const {
+  return _shards[std::hash<std::string>()(name) % _shards.size()];
+}
+
+testcase_registry::entry_ptr testcase_registry::find_or_create(
+    const std::string& name, const std::function<entry_ptr()>& create) {
+  auto& shard = shard_of(name);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto& entry = shard.entries[name];
+  if (!entry) {
+    entry = create();
+  }
+  return entry;
+}
+
+testcase_registry::entry_ptr testcase_registry::find(
+    const std::string& name) const {
+  const auto& shard = shard_of(name);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  const auto it = shard.entries.find(name);
+  return it == shard.entries.end() ? nullptr : it->second;
+}
+
+testcase_registry::entry_ptr testcase_registry::erase(
+    const std::string& name) {
+  auto& shard = shard_of(name);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  const auto it = shard.entries.find(name);
+  if (it == shard.entries.end()) {
+    return nullptr;
+  }
+  const auto entry = it->second;
+  shard.entries.erase(it);
+  return entry;
+}
+
+std::vector<std::pair<std::string, testcase_registry::entry_ptr>>
+testcase_registry::entries() const {
+  std::vector<std::pair<std::string, entry_ptr>> entries;
+  for (const auto& shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    entries.insert(entries.end(), shard.entries.begin(), shard.entries.end());
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const std::pair<std::string, entry_ptr>& lhs,
+               const std::pair<std::string, entry_ptr>& rhs) {
+              return lhs.first < rhs.first;
+            });
+  return entries;
+}
+
+void capture_state::bind(std::shared_ptr<testcase_entry> next) {
+  buffer = next ? next->buffer() : nullptr;
+  entry = std::move(next);
+}
+
+}  // namespace detail
+}  // namespace touca
@@ -2,7 +2,11 @@
 
 #include "touca/client/detail/client.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <sstream>
 
 #include "nlohmann/json.hpp"
@@ -15,14 +19,42 @@
 /** maximum number of attempts to re-submit failed http requests */
 constexpr unsigned post_max_retries = 2;
 
-/** maximum number of cases to be posted in a single http request */
-constexpr unsigned post_max_cases = 10;
+/** maximum number of requests queued for submission in the background */
+constexpr unsigned post_queue_capacity = 16;
 
 namespace touca {
 
+/**
+ * Finds the state of the calling thread for a given client. States of
+ * a client that is destroyed are kept until their thread exits.
+ */
+static detail::capture_state& thread_state(const std::uint64_t client) {
+  static thread_local std::unordered_map<std::uint64_t, detail::capture_state>
+      states;
+  static thread_local std::pair<std::uint64_t, detail::capture_state*>
+      recent = {0u, nullptr};
+  if (recent.first != client) {
+    recent = std::make_pair(client, &states[client]);
+  }
+  return *recent.second;
+}
+
+static std::uint64_t next_client_id() {
+  static std::atomic<std::uint64_t> count(0u);
+  return ++count;
+}
+
+ClientImpl::ClientImpl() : _declarations(0u), _id(next_client_id()) {}
+
 bool ClientImpl::configure(const ClientImpl::OptionsMap& opts) {
   _config_error.clear();
-  parse_options(opts, _options);
+  try {
+    parse_options(opts, _options);
+  } catch (const std::exception& ex) {
+    _config_error = ex.what();
+    _configured = false;
+    return false;
+  }
   return apply_options();
 }
 
@@ -33,6 +65,10 @@ bool ClientImpl::configure(const ClientOptions& options) {
 }
 
 bool ClientImpl::apply_options() {
+  // results that are still queued for submission are submitted before
+  // the platform that they are submitted to is replaced.
+  _submissions.reset();
+
   try {
     if (reformat_options(_options)) {
       _configured = true;
@@ -44,17 +80,50 @@ bool ClientImpl::apply_options() {
     return false;
   }
 
+  // wait for any authentication still performed in the background
+  // before we replace the platform that it uses.
+  if (_session.valid()) {
+    _session.wait();
+  }
+
   // perform authentication to server using the provided
   // API key and obtain API token for posting results.
   ApiUrl api_url(_options.api_url);
   _platform = std::unique_ptr<Platform>(new Platform(api_url));
-  if (!_platform->auth(_options.api_key)) {
-    _config_error = _platform->get_error();
-    return false;
+  if (!_options.cache_dir.empty()) {
+    _platform->set_cache(_options.cache_dir,
+                         std::chrono::seconds(_options.cache_ttl));
   }
+  const auto platform = _platform.get();
+  const auto api_key = _options.api_key;
+  const auto level = _options.compression_level;
+  const auto connect = [this, platform, api_key, level]() -> std::string {
+    if (!platform->auth(api_key)) {
+      return platform->get_error();
+    }
+    // compress submitted results if the server accepts compressed content
+    if (level != 0u &&
+        (!platform->handshake() || platform->compress(level).empty())) {
+      notify_loggers(logger::Level::Warning,
+                     "submitting results uncompressed since compression is "
+                     "not supported");
+    }
+    return "";
+  };
 
-  // retrieve list of known test cases for this suite
-  if (_options.testcases.empty()) {
+  // if the list of testcases is known, we authenticate in the background
+  // so that testcases can be executed in the meantime. any failure is
+  // reported once results are posted.
+  const auto background = !_options.testcases.empty();
+  _session = std::async(background ? std::launch::async : std::launch::deferred,
+                        connect)
+                 .share();
+  if (!background) {
+    if (!_session.get().empty()) {
+      _config_error = _session.get();
+      return false;
+    }
+    // retrieve list of known test cases for this suite
     _options.testcases = _platform->elements();
     if (_options.testcases.empty()) {
       _config_error = _platform->get_error();
@@ -62,6 +131,11 @@ bool ClientImpl::apply_options() {
     }
   }
 
+  if (_options.async_post) {
+    _submissions =
+        detail::make_unique<detail::submission_queue>(post_queue_capacity);
+  }
+
   _configured = true;
   return true;
 }
@@ -77,6 +151,7 @@ bool ClientImpl::configure_by_file(const touca::filesystem::path& path) {
 }
 
 void ClientImpl::add_logger(std::shared_ptr<logger> logger) {
+  std::lock_guard<std::mutex> lock(_loggers_mutex);
   _loggers.push_back(logger);
 }
 
@@ -89,66 +164,113 @@ std::shared_ptr<touca::Testcase> ClientImpl::declare_testcase(
   if (!_configured) {
     return nullptr;
   }
-  if (!_testcases.count(name)) {
-    const auto& tc = std::make_shared<Testcase>(_options.team, _options.suite,
-                                                _options.revision, name);
-    _testcases.emplace(name, tc);
-  }
-  _threadMap[std::this_thread::get_id()] = name;
-  _mostRecentTestcase = name;
-  return _testcases.at(name);
+  const auto& entry = _testcases.find_or_create(name, [this, &name]() {
+    return std::make_shared<detail::testcase_entry>(
+        std::make_shared<Testcase>(_options.team, _options.suite,
+                                   _options.revision, name, _options.arena),
+        _options.arena);
+  });
+  auto& state = thread_state(_id);
+  state.bind(entry);
+  state.pinned = false;
+  std::lock_guard<std::mutex> lock(_mostRecentMutex);
+  _mostRecentTestcase = entry;
+  state.declarations = ++_declarations;
+  return entry->testcase();
 }
 
 void ClientImpl::forget_testcase(const std::string& name) {
-  if (!_testcases.count(name)) {
+  const auto& entry = _testcases.erase(name);
+  if (!entry) {
     const auto err = touca::detail::format("key `{}` does not exist", name);
     notify_loggers(logger::Level::Warning, err);
     throw std::invalid_argument(err);
   }
-  _testcases.at(name)->clear();
-  _testcases.erase(name);
+  entry->forget();
+  entry->apply([](Testcase& testcase) { testcase.clear(); });
+  std::lock_guard<std::mutex> lock(_mostRecentMutex);
+  if (_mostRecentTestcase == entry) {
+    _mostRecentTestcase.reset();
+    ++_declarations;
+  }
+}
+
+std::shared_ptr<detail::testcase_entry> ClientImpl::find_testcase(
+    const std::string& name) const {
+  return _testcases.find(name);
+}
+
+std::shared_ptr<detail::testcase_entry> ClientImpl::current_testcase() const {
+  const auto state = get_last_testcase();
+  return state ? state->entry : nullptr;
+}
+
+std::shared_ptr<detail::capture_buffer> ClientImpl::current_buffer() const {
+  const auto state = get_last_testcase();
+  return state ? state->buffer : nullptr;
 }
 
-void ClientImpl::check(const std::string& key, const data_point& value) {
-  if (has_last_testcase()) {
-    _testcases.at(get_last_testcase())->check(key, value);
+detail::capture_state ClientImpl::enter_context(
+    std::shared_ptr<detail::testcase_entry> entry) {
+  auto& state = thread_state(_id);
+  auto previous = state;
+  state.bind(std::move(entry));
+  state.pinned = true;
+  return previous;
+}
+
+void ClientImpl::leave_context(detail::capture_state previous) {
+  thread_state(_id) = std::move(previous);
+}
+
+void ClientImpl::check(const touca::key& key, data_point value) {
+  if (const auto state = get_last_testcase()) {
+    state->buffer->check(key, std::move(value));
   }
 }
 
-void ClientImpl::assume(const std::string& key, const data_point& value) {
-  if (has_last_testcase()) {
-    _testcases.at(get_last_testcase())->assume(key, value);
+void ClientImpl::assume(const touca::key& key, data_point value) {
+  if (const auto state = get_last_testcase()) {
+    state->buffer->assume(key, std::move(value));
   }
 }
 
-void ClientImpl::add_array_element(const std::string& key,
-                                   const data_point& value) {
-  if (has_last_testcase()) {
-    _testcases.at(get_last_testcase())->add_array_element(key, value);
+void ClientImpl::add_results(detail::result_list checks,
+                             detail::result_list assumptions) {
+  if (const auto state = get_last_testcase()) {
+    state->buffer->add_results(std::move(checks), std::move(assumptions));
   }
 }
 
-void ClientImpl::add_hit_count(const std::string& key) {
-  if (has_last_testcase()) {
-    _testcases.at(get_last_testcase())->add_hit_count(key);
+void ClientImpl::add_array_element(const touca::key& key, data_point value) {
+  if (const auto state = get_last_testcase()) {
+    state->buffer->add_array_element(key, std::move(value));
+  }
+}
+
+void ClientImpl::add_hit_count(const touca::key& key) {
+  if (const auto state = get_last_testcase()) {
+    state->buffer->add_hit_count(key);
   }
 }
 
 void ClientImpl::add_metric(const std::string& key, const unsigned duration) {
-  if (has_last_testcase()) {
-    _testcases.at(get_last_testcase())->add_metric(key, duration);
+  if (const auto state = get_last_testcase()) {
+    state->entry->apply([&key, duration](Testcase& testcase) {
+      testcase.add_metric(key, duration);
+    });
   }
 }
 
 void ClientImpl::start_timer(const std::string& key) {
-  if (has_last_testcase()) {
-    _testcases.at(get_last_testcase())->tic(key);
+  if (const auto state = get_last_testcase()) {
+    state->entry->tic(key);
   }
 }
 
 void ClientImpl::stop_timer(const std::string& key) {
-  if (has_last_testcase()) {
-    _testcases.at(get_last_testcase())->toc(key);
+  if (const auto state = get_last_testcase()) {
+    state->entry->toc(key);
   }
 }
 
@@ -161,9 +283,9 @@ void ClientImpl::save(const touca::filesystem::path& path,
 
   auto tcs = testcases;
   if (tcs.empty()) {
-    std::transform(
-        _testcases.begin(), _testcases.end(), std::back_inserter(tcs),
-        [](const ElementsMap::value_type& kvp) { return kvp.first; });
+    for (const auto& entry : _testcases.entries()) {
+      tcs.push_back(entry.first);
+    }
   }
 
   switch (format) {
@@ -178,156 +300,354 @@ void ClientImpl::save(const touca::filesystem::path& path,
   }
 }
 
+/**
+ * Collects the serialized form of given testcases, which is cached by
+ * each testcase, so that they can be written without copying them.
+ */
+static std::vector<std::shared_ptr<const std::vector<uint8_t>>> messages_of(
+    const std::vector<std::shared_ptr<detail::testcase_entry>>& entries) {
+  std::vector<std::shared_ptr<const std::vector<uint8_t>>> messages;
+  messages.reserve(entries.size());
+  for (const auto& entry : entries) {
+    entry->apply([&messages](Testcase& testcase) {
+      messages.push_back(testcase.message());
+    });
+  }
+  return messages;
+}
+
 bool ClientImpl::post() const {
   // check that client is configured to submit test results
 
-  if (!_platform) {
-    notify_loggers(logger::Level::Error,
-                   "client is not configured to contact server");
-    return false;
-  }
-  if (!_platform->has_token()) {
-    notify_loggers(logger::Level::Error,
-                   "client is not authenticated to the server");
+  if (!is_platform_ready()) {
     return false;
   }
 
-  auto ret = true;
   // we should only post testcases that we have not posted yet
   // or those that have changed since we last posted them.
-  std::vector<std::string> testcases;
-  for (const auto& tc : _testcases) {
-    if (!tc.second->_posted) {
-      testcases.emplace_back(tc.first);
+  std::vector<std::shared_ptr<detail::testcase_entry>> entries;
+  for (const auto& entry : _testcases.entries()) {
+    merge(*entry.second);
+    auto posted = true;
+    entry.second->apply(
+        [&posted](Testcase& testcase) { posted = testcase._posted; });
+    if (!posted) {
+      entries.emplace_back(entry.second);
     }
   }
-  // group multiple testcases together according to `_postMaxTestcases`
-  // configuration parameter and post each group separately in
-  // flatbuffers format.
-  for (auto it = testcases.begin(); it != testcases.end();) {
-    const auto& tail = it + (std::min)(static_cast<ptrdiff_t>(post_max_cases),
-                                       std::distance(it, testcases.end()));
-    std::vector<std::string> batch(it, tail);
-    // attempt to post results for this group of testcases.
-    // currently we only support posting data in flatbuffers format.
-    const auto isPosted = post_flatbuffers(find_testcases(batch));
-    it = tail;
-    if (!isPosted) {
-      notify_loggers(logger::Level::Error,
-                     "failed to post test results for a group of testcases");
-      ret = false;
-      continue;
-    }
-    for (const auto& tc : batch) {
-      _testcases.at(tc)->_posted = true;
-    }
+  if (entries.empty()) {
+    return true;
+  }
+  // results merged into a testcase while we post it mark it as not
+  // posted again.
+  for (const auto& entry : entries) {
+    entry->apply([](Testcase& testcase) { testcase._posted = true; });
   }
-  return ret;
+  // testcases are serialized before they are queued, since they may be
+  // changed or forgotten by the time they are submitted. the submission
+  // shares their serialized form rather than copying their results.
+  // currently we only support posting data in flatbuffers format.
+  auto messages = messages_of(entries);
+
+  // in asynchronous mode, testcases are submitted by a background
+  // thread. testcases that fail to be submitted are kept by the queue,
+  // which submits them again on `flush`, since they may be forgotten
+  // by then. any failure is reported by `flush`.
+  if (_submissions) {
+    using message_ptr = std::shared_ptr<const std::vector<uint8_t>>;
+    struct submission {
+      std::vector<std::shared_ptr<detail::testcase_entry>> entries;
+      std::vector<message_ptr> messages;
+    };
+    const auto pending = std::make_shared<submission>(
+        submission{std::move(entries), std::move(messages)});
+    _submissions->push([this, pending]() -> bool {
+      const auto failed =
+          post_flatbuffers(pending->entries, pending->messages);
+      submission remaining;
+      for (const auto& k : failed) {
+        remaining.entries.push_back(pending->entries[k]);
+        remaining.messages.push_back(pending->messages[k]);
+      }
+      *pending = std::move(remaining);
+      return failed.empty();
+    });
+    return true;
+  }
+
+  // testcases that fail to be submitted are posted again by the next
+  // call to `post`.
+  const auto failed = post_flatbuffers(entries, messages);
+  for (const auto& k : failed) {
+    entries[k]->apply([](Testcase& testcase) { testcase._posted = false; });
+  }
+  return failed.empty();
+}
+
+bool ClientImpl::flush() const {
+  return !_submissions || _submissions->wait();
 }
 
 bool ClientImpl::seal() const {
+  if (!is_platform_ready()) {
+    return false;
+  }
+  if (!flush()) {
+    notify_loggers(logger::Level::Warning,
+                   "version is not sealed since some test results were "
+                   "not submitted");
+    return false;
+  }
+  if (!_platform->set_params(_options.team, _options.suite,
+                             _options.revision) ||
+      !_platform->seal()) {
+    notify_loggers(logger::Level::Warning, _platform->get_error());
+    return false;
+  }
+  return true;
+}
+
+bool ClientImpl::is_platform_ready() const {
   if (!_platform) {
     notify_loggers(logger::Level::Error,
                    "client is not configured to contact server");
     return false;
   }
+  const auto& error = _session.get();
+  if (!error.empty()) {
+    notify_loggers(logger::Level::Error, error);
+  }
   if (!_platform->has_token()) {
     notify_loggers(logger::Level::Error,
                    "client is not authenticated to the server");
     return false;
-  };
-  if (!_platform->set_params(_options.team, _options.suite,
-                             _options.revision) ||
-      !_platform->seal()) {
-    notify_loggers(logger::Level::Warning, _platform->get_error());
-    return false;
   }
   return true;
 }
 
 bool ClientImpl::has_last_testcase() const {
+  return get_last_testcase() != nullptr;
+}
+
+detail::capture_state* ClientImpl::get_last_testcase() const {
   // if client is not configured, report that no testcase has been
   // declared. this behavior renders calls to other data capturing
   // functions as no-op which is helpful in production environments
   // where `configure` is expected to never be called.
 
   if (!_configured) {
-    return false;
+    return nullptr;
   }
 
+  auto& state = thread_state(_id);
+
   // If client is configured, check whether testcase declaration is set as
   // "shared" in which case report the most recently declared testcase.
-
-  if (!_options.single_thread) {
-    return !_mostRecentTestcase.empty();
+  // Threads only take the lock if another thread declared a testcase
+  // since they last captured a result.
+
+  if (!_options.single_thread && !state.pinned) {
+    const auto declarations = _declarations.load(std::memory_order_acquire);
+    if (state.declarations != declarations) {
+      std::lock_guard<std::mutex> lock(_mostRecentMutex);
+      state.bind(_mostRecentTestcase);
+      state.declarations = _declarations.load(std::memory_order_relaxed);
+    }
   }
 
-  // If testcase declaration is "thread-specific", check if this thread
-  // has declared any testcase before.
-
-  return _threadMap.count(std::this_thread::get_id());
-}
+  // If testcase declaration is "thread-specific" or if the testcase is
+  // installed by a context scope, report the testcase of this thread, if
+  // any. If that testcase was forgotten, release it rather than keeping
+  // it, and the results buffered for it, until this thread exits.
 
-std::string ClientImpl::get_last_testcase() const {
-  // We do not expect this function to be called without calling
-  // `has_last_testcase` first.
-
-  if (!has_last_testcase()) {
-    throw std::logic_error("testcase not declared");
+  if (state.entry && state.entry->forgotten()) {
+    state.bind(nullptr);
   }
-
-  // If client is configured, check whether testcase declaration is set as
-  // "shared" in which case report the name of the most recently declared
-  // testcase.
-
-  if (!_options.single_thread) {
-    return _mostRecentTestcase;
+  if (!state.entry) {
+    return nullptr;
   }
+  return &state;
+}
 
-  // If testcase declaration is "thread-specific", report the most recent
-  // testcase declared by this thread.
-
-  return _threadMap.at(std::this_thread::get_id());
+void ClientImpl::merge(detail::testcase_entry& entry) const {
+  for (const auto& key : entry.flush()) {
+    notify_loggers(logger::Level::Warning,
+                   touca::detail::format(
+                       "dropped result `{}` captured multiple times "
+                       "with different types",
+                       key));
+  }
 }
 
-std::vector<Testcase> ClientImpl::find_testcases(
-    const std::vector<std::string>& names) const {
-  std::vector<Testcase> testcases;
-  testcases.reserve(names.size());
+std::vector<std::shared_ptr<detail::testcase_entry>>
+ClientImpl::find_testcases(const std::vector<std::string>& names) const {
+  std::vector<std::shared_ptr<detail::testcase_entry>> entries;
+  entries.reserve(names.size());
   for (const auto& name : names) {
-    testcases.emplace_back(*_testcases.at(name));
+    const auto& entry = _testcases.find(name);
+    if (!entry) {
+      throw std::out_of_range(
+          touca::detail::format("testcase `{}` does not exist", name));
+    }
+    merge(*entry);
+    entries.push_back(entry);
   }
-  return testcases;
+  return entries;
 }
 
-void ClientImpl::save_json(const touca::filesystem::path& path,
-                           const std::vector<Testcase>& testcases) const {
+void ClientImpl::save_json(
+    const touca::filesystem::path& path,
+    const std::vector<std::shared_ptr<detail::testcase_entry>>& entries)
+    const {
   nlohmann::ordered_json doc = nlohmann::json::array();
-  for (const auto& testcase : testcases) {
-    doc.push_back(testcase.json());
+  for (const auto& entry : entries) {
+    entry->apply(
+        [&doc](Testcase& testcase) { doc.push_back(testcase.json()); });
   }
   detail::save_string_file(path.string(), doc.dump());
 }
 
 void ClientImpl::save_flatbuffers(
     const touca::filesystem::path& path,
-    const std::vector<Testcase>& testcases) const {
-  detail::save_binary_file(path.string(), Testcase::serialize(testcases));
+    const std::vector<std::shared_ptr<detail::testcase_entry>>& entries)
+    const {
+  auto writer = acquire_writer();
+  writer->write(messages_of(entries));
+  detail::save_binary_file(path.string(), writer->data(), writer->size());
+  release_writer(std::move(writer));
+  // the serialized form is only kept for testcases that may be posted
+  for (const auto& entry : entries) {
+    entry->apply([this](Testcase& testcase) {
+      if (!_platform || testcase._posted) {
+        testcase.release_message();
+      }
+    });
+  }
 }
 
-bool ClientImpl::post_flatbuffers(
-    const std::vector<Testcase>& testcases) const {
-  const auto& buffer = Testcase::serialize(testcases);
-  std::string content((const char*)buffer.data(), buffer.size());
-  const auto& errors = _platform->submit(content, post_max_retries);
+std::vector<std::size_t> ClientImpl::post_flatbuffers(
+    const std::vector<std::shared_ptr<detail::testcase_entry>>& entries,
+    const std::vector<std::shared_ptr<const std::vector<uint8_t>>>& messages)
+    const {
+  const auto& tic = std::chrono::steady_clock::now();
+  const auto& stats = _platform->submit_stats();
+  std::vector<std::size_t> sizes;
+  sizes.reserve(messages.size());
+  for (const auto& message : messages) {
+    sizes.push_back(message->size());
+  }
+
+  // group testcases into requests of up to `post_batch_bytes` so that
+  // small testcases share a request while large ones do not exceed it.
+  auto groups = detail::split_by_size(sizes, _options.post_batch_bytes);
+  groups.push_back(messages.size());
+  const auto count = groups.size() - 1u;
+
+  // up to `post_concurrency` requests are kept in flight while the
+  // next request is serialized.
+  struct request {
+    std::size_t group;
+    std::unique_ptr<detail::messages_writer> writer;
+    std::future<std::vector<std::string>> errors;
+  };
+  std::deque<request> requests;
+  std::size_t total = 0u;
+  std::vector<std::string> errors;
+  std::vector<std::size_t> failed;
+  const auto complete = [this, &requests, &errors, &failed]() {
+    auto& request = requests.front();
+    const auto& errs = request.errors.get();
+    if (!errs.empty()) {
+      errors.insert(errors.end(), errs.begin(), errs.end());
+      failed.push_back(request.group);
+    }
+    release_writer(std::move(request.writer));
+    requests.pop_front();
+  };
+  const auto concurrency = (std::max)(_options.post_concurrency, 1u);
+  for (std::size_t i = 0u; i < count; ++i) {
+    if (requests.size() == concurrency) {
+      complete();
+    }
+    const std::vector<std::shared_ptr<const std::vector<uint8_t>>> group(
+        messages.begin() + groups[i], messages.begin() + groups[i + 1u]);
+    auto writer = acquire_writer();
+    writer->write(group);
+    total += writer->size();
+    auto result = _platform->submit_async(writer->data(), writer->size(),
+                                          post_max_retries);
+    requests.push_back(request{i, std::move(writer), std::move(result)});
+  }
+  while (!requests.empty()) {
+    complete();
+  }
+
   for (const auto& err : errors) {
     notify_loggers(logger::Level::Warning, err);
   }
-  return errors.empty();
+  // the serialized form of posted testcases is no longer needed
+  for (std::size_t i = 0u; i < count; ++i) {
+    if (std::find(failed.begin(), failed.end(), i) != failed.end()) {
+      continue;
+    }
+    for (auto k = groups[i]; k < groups[i + 1u]; ++k) {
+      entries[k]->apply(
+          [](Testcase& testcase) { testcase.release_message(); });
+    }
+  }
+  std::vector<std::size_t> unposted;
+  for (const auto& i : failed) {
+    notify_loggers(logger::Level::Error,
+                   "failed to post test results for a group of testcases");
+    for (auto k = groups[i]; k < groups[i + 1u]; ++k) {
+      unposted.push_back(k);
+    }
+  }
+
+  const auto& toc = std::chrono::steady_clock::now();
+  const auto ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(toc - tic).count();
+  notify_loggers(
+      logger::Level::Info,
+      fmt::format("submitted {} testcases in {} requests: {} bytes in {} ms "
+                  "({:.2f} MB/s)",
+                  entries.size(), count, total, ms,
+                  ms == 0 ? 0.0 : total / 1e3 / static_cast<double>(ms)));
+
+  // statistics of concurrent calls to `post` may include each other's
+  // requests, which is acceptable for logging purposes.
+  const auto& latest = _platform->submit_stats();
+  const auto requests_sent = latest.requests - stats.requests;
+  const auto retries = latest.retries - stats.retries;
+  const auto latency = (latest.latency - stats.latency).count();
+  notify_loggers(
+      retries == 0u ? logger::Level::Debug : logger::Level::Info,
+      fmt::format("retried {} of {} requests to submit testcases with an "
+                  "average latency of {} ms",
+                  retries, requests_sent,
+                  requests_sent == 0u ? 0 : latency / requests_sent));
+  return unposted;
+}
+
+std::unique_ptr<detail::messages_writer> ClientImpl::acquire_writer() const {
+  std::lock_guard<std::mutex> lock(_writers_mutex);
+  if (_writers.empty()) {
+    return detail::make_unique<detail::messages_writer>();
+  }
+  auto writer = std::move(_writers.back());
+  _writers.pop_back();
+  return writer;
+}
+
+void ClientImpl::release_writer(
+    std::unique_ptr<detail::messages_writer> writer) const {
+  std::lock_guard<std::mutex> lock(_writers_mutex);
+  _writers.push_back(std::move(writer));
 }
 
 void ClientImpl::notify_loggers(const logger::Level severity,
                                 const std::string& msg) const {
+  std::lock_guard<std::mutex> lock(_loggers_mutex);
   for (const auto& logger : _loggers) {
     logger->log(severity, msg);
   }
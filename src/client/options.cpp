@@ -2,6 +2,11 @@
 
 #include "touca/client/detail/options.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+
 #include "nlohmann/json.hpp"
 #include "touca/core/filesystem.hpp"
 #include "touca/devkit/platform.hpp"
@@ -22,6 +27,32 @@ template <>
 func_t parse_member(bool& member) {
   return [&member](const std::string& value) { member = value != "false"; };
 }
+
+template <>
+func_t parse_member(unsigned& member) {
+  return [&member](const std::string& value) {
+    const auto& error = std::invalid_argument(
+        fmt::format("expected a number but got \"{}\"", value));
+    // `std::stoul` accepts a sign and wraps negative values around, so
+    // we only accept digits and check the range ourselves.
+    if (value.empty() ||
+        !std::all_of(value.begin(), value.end(), [](const char c) {
+          return std::isdigit(static_cast<unsigned char>(c)) != 0;
+        })) {
+      throw error;
+    }
+    unsigned long long number = 0u;
+    try {
+      number = std::stoull(value);
+    } catch (const std::exception&) {
+      throw error;
+    }
+    if (std::numeric_limits<unsigned>::max() < number) {
+      throw error;
+    }
+    member = static_cast<unsigned>(number);
+  };
+}
 }  // namespace detail
 
 /**
@@ -111,6 +142,16 @@ void parse_options(const std::unordered_map<std::string, std::string>& incoming,
   parsers.emplace("offline", detail::parse_member(existing.offline));
   parsers.emplace("single-thread",
                   detail::parse_member(existing.single_thread));
+  parsers.emplace("arena", detail::parse_member(existing.arena));
+  parsers.emplace("async-post", detail::parse_member(existing.async_post));
+  parsers.emplace("post-batch-bytes",
+                  detail::parse_member(existing.post_batch_bytes));
+  parsers.emplace("post-concurrency",
+                  detail::parse_member(existing.post_concurrency));
+  parsers.emplace("compression-level",
+                  detail::parse_member(existing.compression_level));
+  parsers.emplace("cache-dir", detail::parse_member(existing.cache_dir));
+  parsers.emplace("cache-ttl", detail::parse_member(existing.cache_ttl));
 
   for (const auto& kvp : incoming) {
     if (parsers.count(kvp.first)) {
@@ -141,10 +182,14 @@ std::unordered_map<std::string, std::string> load_options(
   // parse configuration parameters from the JSON content.
   std::unordered_map<std::string, std::string> options;
   const auto& config = parsed["touca"];
-  for (const auto& key : {"team", "suite", "version", "api-key", "api-url",
-                          "offline", "single-thread"}) {
+  for (const auto& key :
+       {"team", "suite", "version", "api-key", "api-url", "offline",
+        "single-thread", "arena", "async-post", "post-batch-bytes",
+        "post-concurrency", "compression-level", "cache-dir", "cache-ttl"}) {
     if (config.contains(key) && config[key].is_string()) {
       options.emplace(key, config[key].get<std::string>());
+    } else if (config.contains(key) && config[key].is_number_unsigned()) {
+      options.emplace(key, std::to_string(config[key].get<unsigned>()));
     }
   }
   return options;
@@ -0,0 +1,99 @@
+// Copyright 2021 Touca, Inc. Subject to Apache-2.0 License.
+
+#include "touca/client/detail/submission.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace touca {
+namespace detail {
+
+submission_queue::submission_queue(const std::size_t capacity)
+    : _capacity(capacity == 0u ? 1u : capacity) {}
+
+submission_queue::~submission_queue() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopped = true;
+  }
+  _pushed.notify_all();
+  if (_worker.joinable()) {
+    _worker.join();
+  }
+}
+
+void submission_queue::push(job submission) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (!_worker.joinable()) {
+    _worker = std::thread(&submission_queue::run, this);
+  }
+  _popped.wait(lock, [this] { return _jobs.size() < _capacity; });
+  _jobs.push_back(std::move(submission));
+  ++_pending;
+  lock.unlock();
+  _pushed.notify_one();
+}
+
+bool submission_queue::wait() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _done.wait(lock, [this] { return _pending == 0u; });
+  if (_failed.empty()) {
+    return true;
+  }
+  // the background thread is running, since submissions have failed.
+  for (auto& submission : _failed) {
+    _jobs.push_back(std::move(submission));
+  }
+  _pending += _failed.size();
+  _failed.clear();
+  lock.unlock();
+  _pushed.notify_one();
+  lock.lock();
+  _done.wait(lock, [this] { return _pending == 0u; });
+  return _failed.empty();
+}
+
+void submission_queue::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _pushed.wait(lock, [this] { return _stopped || !_jobs.empty(); });
+    // pending submissions are performed even if the queue is stopped
+    if (_jobs.empty()) {
+      return;
+    }
+    auto submission = std::move(_jobs.front());
+    _jobs.pop_front();
+    lock.unlock();
+    _popped.notify_one();
+    auto submitted = false;
+    try {
+      submitted = submission();
+    } catch (const std::exception&) {
+      // submissions that throw are regarded as failed
+    }
+    lock.lock();
+    if (!submitted) {
+      _failed.push_back(std::move(submission));
+    }
+    if (--_pending == 0u) {
+      _done.notify_all();
+    }
+  }
+}
+
+std::vector<std::size_t> split_by_size(const std::vector<std::size_t>& sizes,
+                                       const std::size_t budget) {
+  std::vector<std::size_t> groups;
+  std::size_t total = 0u;
+  for (std::size_t i = 0u; i < sizes.size(); ++i) {
+    if (groups.empty() || budget < total + sizes[i]) {
+      groups.push_back(i);
+      total = 0u;
+    }
+    total += sizes[i];
+  }
+  return groups;
+}
+
+}  // namespace detail
+}  // namespace touca
@@ -25,8 +25,9 @@ void add_logger(const std::shared_ptr<logger> logger) {
 
 std::vector<std::string> get_testcases() { return instance.get_testcases(); }
 
-void declare_testcase(const std::string& name) {
+testcase_handle declare_testcase(const std::string& name) {
   instance.declare_testcase(name);
+  return testcase_handle(instance.find_testcase(name));
 }
 
 void forget_testcase(const std::string& name) {
@@ -35,21 +36,66 @@ void forget_testcase(const std::string& name) {
 
 namespace detail {
 
-void check(const std::string& key, const data_point& value) {
-  instance.check(key, value);
+bool is_capturing() { return instance.has_last_testcase(); }
+
+std::shared_ptr<capture_buffer> current_buffer() {
+  return instance.current_buffer();
+}
+
+void check(const touca::key& key, data_point value) {
+  instance.check(key, std::move(value));
 }
 
-void assume(const std::string& key, const data_point& value) {
-  instance.assume(key, value);
+void assume(const touca::key& key, data_point value) {
+  instance.assume(key, std::move(value));
 }
 
-void add_array_element(const std::string& key, const data_point& value) {
-  instance.add_array_element(key, value);
+void add_array_element(const touca::key& key, data_point value) {
+  instance.add_array_element(key, std::move(value));
+}
+
+void add_results(result_list checks, result_list assumptions) {
+  instance.add_results(std::move(checks), std::move(assumptions));
 }
 
 }  // namespace detail
 
-void add_hit_count(const std::string& key) { instance.add_hit_count(key); }
+void add_hit_count(const touca::key& key) { instance.add_hit_count(key); }
+
+hit_counter make_counter(const touca::key& key) {
+  const auto& entry = instance.current_testcase();
+  return entry ? hit_counter(entry->counter(key)) : hit_counter();
+}
+
+array_appender make_appender(const touca::key& key) {
+  return array_appender(detail::make_sink(key, detail::internal_type::array));
+}
+
+namespace detail {
+
+std::shared_ptr<array_sink> make_sink(const touca::key& key,
+                                      const internal_type element_type) {
+  const auto& entry = instance.current_testcase();
+  return entry ? entry->sink(key, element_type) : nullptr;
+}
+
+void append(array_sink& sink, const number_signed_t value) {
+  sink.append(value);
+}
+
+void append(array_sink& sink, const number_unsigned_t value) {
+  sink.append(value);
+}
+
+void append(array_sink& sink, const number_float_t value) {
+  sink.append(value);
+}
+
+void append(array_sink& sink, const number_double_t value) {
+  sink.append(value);
+}
+
+}  // namespace detail
 
 void add_metric(const std::string& key, const unsigned duration) {
   instance.add_metric(key, duration);
@@ -73,8 +119,77 @@ void save_json(const std::string& path,
 
 bool post() { return instance.post(); }
 
+bool flush() { return instance.flush(); }
+
 bool seal() { return instance.seal(); }
 
+testcase_handle::testcase_handle(std::shared_ptr<detail::testcase_entry> entry)
+    : _entry(std::move(entry)),
+      _buffer(_entry ? _entry->buffer() : nullptr) {}
+
+void testcase_handle::add_hit_count(const touca::key& key) {
+  if (_entry) {
+    _buffer->add_hit_count(key);
+  }
+}
+
+hit_counter testcase_handle::make_counter(const touca::key& key) {
+  return _entry ? hit_counter(_entry->counter(key)) : hit_counter();
+}
+
+array_appender testcase_handle::make_appender(const touca::key& key) {
+  return array_appender(make_sink(key, detail::internal_type::array));
+}
+
+std::shared_ptr<detail::array_sink> testcase_handle::make_sink(
+    const touca::key& key, const detail::internal_type element_type) {
+  return _entry ? _entry->sink(key, element_type) : nullptr;
+}
+
+void testcase_handle::add_metric(const std::string& key,
+                                 const unsigned duration) {
+  if (_entry) {
+    _entry->apply([&key, duration](Testcase& testcase) {
+      testcase.add_metric(key, duration);
+    });
+  }
+}
+
+void testcase_handle::start_timer(const std::string& key) {
+  if (_entry) {
+    _entry->tic(key);
+  }
+}
+
+void testcase_handle::stop_timer(const std::string& key) {
+  if (_entry) {
+    _entry->toc(key);
+  }
+}
+
+testcase_context::testcase_context(
+    std::shared_ptr<detail::testcase_entry> entry)
+    : _entry(std::move(entry)) {}
+
+testcase_context testcase_context::current() {
+  return testcase_context(instance.current_testcase());
+}
+
+context_scope::context_scope(const testcase_context& context)
+    : _previous(detail::make_unique<detail::capture_state>(
+          instance.enter_context(context._entry))) {}
+
+context_scope::~context_scope() {
+  instance.leave_context(std::move(*_previous));
+}
+
+array_appender::array_appender(std::shared_ptr<detail::array_sink> sink)
+    : _sink(std::move(sink)) {}
+
+void array_appender::add_value(data_point value) {
+  _sink->append(std::move(value));
+}
+
 scoped_timer::scoped_timer(const std::string& name) : _name(name) {
   instance.start_timer(_name);
 }
@@ -0,0 +1,61 @@
+// Copyright 2021 Touca, Inc. Subject to Apache-2.0 License.
+
+#include "touca/core/arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace touca {
+namespace detail {
+
+static thread_local arena* current_arena = nullptr;
+
+arena::arena(const std::size_t block_size) : _block_size(block_size) {}
+
+arena::~arena() { release(); }
+
+void* arena::allocate(const std::size_t size, const std::size_t alignment) {
+  const auto align = [alignment](unsigned char* ptr) {
+    const auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+    const auto padding = (alignment - addr % alignment) % alignment;
+    return ptr + padding;
+  };
+  auto ptr = _cursor ? align(_cursor) : nullptr;
+  if (!ptr || _end < ptr || static_cast<std::size_t>(_end - ptr) < size) {
+    // requests larger than our block size get a block of their own
+    const auto payload = (std::max)(_block_size, size + alignment);
+    const auto length = sizeof(block) + payload;
+    auto next = static_cast<block*>(::operator new(length));
+    next->next = _head;
+    _head = next;
+    _capacity += length;
+    _cursor = reinterpret_cast<unsigned char*>(next) + sizeof(block);
+    _end = _cursor + payload;
+    ptr = align(_cursor);
+  }
+  _cursor = ptr + size;
+  return ptr;
+}
+
+void arena::release() noexcept {
+  while (_head) {
+    auto next = _head->next;
+    ::operator delete(_head);
+    _head = next;
+  }
+  _cursor = nullptr;
+  _end = nullptr;
+  _capacity = 0;
+}
+
+arena* active_arena() noexcept { return current_arena; }
+
+arena_scope::arena_scope(arena* scope) noexcept : _previous(current_arena) {
+  current_arena = scope;
+}
+
+arena_scope::~arena_scope() { current_arena = _previous; }
+
+}  // namespace detail
+}  // namespace touca
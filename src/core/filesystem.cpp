@@ -61,10 +61,15 @@ void save_string_file(const std::string& path, const std::string& content) {
 
 void save_binary_file(const std::string& path,
                       const std::vector<uint8_t>& data) {
+  save_binary_file(path, data.data(), data.size());
+}
+
+void save_binary_file(const std::string& path, const uint8_t* data,
+                      const std::size_t size) {
   create_parent_directory(path);
   try {
     std::ofstream out(path, std::ios::binary);
-    out.write((const char*)data.data(), data.size());
+    out.write((const char*)data, size);
     out.close();
   } catch (const std::exception& ex) {
     throw std::invalid_argument(
@@ -2,6 +2,9 @@
 
 #include "touca/core/testcase.hpp"
 
+#include <ctime>
+#include <utility>
+
 #include "flatbuffers/flatbuffers.h"
 #include "nlohmann/json.hpp"
 #include "touca/core/filesystem.hpp"
@@ -11,8 +14,11 @@
 namespace touca {
 
 Testcase::Testcase(const std::string& teamslug, const std::string& testsuite,
-                   const std::string& version, const std::string& name)
-    : _posted(false) {
+                   const std::string& version, const std::string& name,
+                   const bool arena)
+    : _posted(false),
+      _arena(arena ? std::make_shared<detail::arena>() : nullptr),
+      _serialized(std::make_shared<Serialized>()) {
   // Add an ISO 8601 timestamp that shows the time of creation of this
   // testcase.
   // We use UTC time instead of local time to ensure that the times
@@ -28,8 +34,16 @@ Testcase::Testcase(const std::string& teamslug, const std::string& testsuite,
                       now.time_since_epoch()) %
                   1000;
   const auto tm = std::chrono::system_clock::to_time_t(now);
+  // `std::gmtime` returns a pointer to shared storage and may race with
+  // threads that declare testcases concurrently.
+  std::tm utc;
+#ifdef _WIN32
+  gmtime_s(&utc, &tm);
+#else
+  gmtime_r(&tm, &utc);
+#endif
   char timestamp[32];
-  std::strftime(timestamp, sizeof(timestamp), "%FT%T", std::gmtime(&tm));
+  std::strftime(timestamp, sizeof(timestamp), "%FT%T", &utc);
   const auto& builtAt = fmt::format("{0}.{1:03}Z", timestamp, ms.count());
 
   _metadata = {teamslug, testsuite, version, name, builtAt};
@@ -38,7 +52,10 @@ Testcase::Testcase(const std::string& teamslug, const std::string& testsuite,
 Testcase::Testcase(
     const Metadata& meta, const ResultsMap& results,
     const std::unordered_map<std::string, detail::number_unsigned_t>& metrics)
-    : _posted(true), _metadata(meta), _resultsMap(results) {
+    : _posted(true),
+      _metadata(meta),
+      _resultsMap(results),
+      _serialized(std::make_shared<Serialized>()) {
   for (const auto& metric : metrics) {
     namespace chr = std::chrono;
     const auto& tic = chr::system_clock::time_point(chr::milliseconds(0));
@@ -49,6 +66,39 @@ Testcase::Testcase(
   }
 }
 
+Testcase& Testcase::operator=(const Testcase& other) {
+  if (this != &other) {
+    _keyIndex.entries.clear();
+    _resultsMap.clear();
+    _posted = other._posted;
+    _metadata = other._metadata;
+    _arena = other._arena;
+    _adopted = other._adopted;
+    _resultsMap = other._resultsMap;
+    _tics = other._tics;
+    _tocs = other._tocs;
+    _serialized = other._serialized;
+  }
+  return *this;
+}
+
+Testcase& Testcase::operator=(Testcase&& other) {
+  if (this != &other) {
+    _keyIndex.entries.clear();
+    _resultsMap.clear();
+    _posted = other._posted;
+    _metadata = std::move(other._metadata);
+    _arena = std::move(other._arena);
+    _adopted = std::move(other._adopted);
+    _resultsMap = std::move(other._resultsMap);
+    other._keyIndex.entries.clear();
+    _tics = std::move(other._tics);
+    _tocs = std::move(other._tocs);
+    _serialized = std::move(other._serialized);
+  }
+  return *this;
+}
+
 nlohmann::ordered_json Testcase::Overview::json() const {
   return nlohmann::ordered_json({{"keysCount", keysCount},
                                  {"metricsCount", metricsCount},
@@ -57,7 +107,10 @@ nlohmann::ordered_json Testcase::Overview::json() const {
 
 Testcase::Metadata Testcase::metadata() const { return _metadata; }
 
-void Testcase::setMetadata(const Metadata& metadata) { _metadata = metadata; }
+void Testcase::setMetadata(const Metadata& metadata) {
+  _metadata = metadata;
+  invalidate();
+}
 
 std::string Testcase::Metadata::describe() const {
   return touca::detail::format("{}/{}/{}/{}", teamslug, testsuite, version,
@@ -76,7 +129,7 @@ nlohmann::ordered_json Testcase::Metadata::json() const {
 
 void Testcase::tic(const std::string& key) {
   _tics.emplace(key, std::chrono::system_clock::now());
-  _posted = false;
+  invalidate();
 }
 
 void Testcase::toc(const std::string& key) {
@@ -84,46 +137,95 @@ void Testcase::toc(const std::string& key) {
     throw std::invalid_argument("timer was never started for given key");
   }
   _tocs[key] = std::chrono::system_clock::now();
-  _posted = false;
+  invalidate();
 }
 
-void Testcase::check(const std::string& key, const data_point& value) {
-  _resultsMap.emplace(key, ResultEntry{value, ResultCategory::Check});
-  _posted = false;
+Testcase::ResultSlot Testcase::find_result(const touca::key& key) {
+  const auto indexed = _keyIndex.entries.find(key.hash());
+  if (indexed != _keyIndex.entries.end() && key == indexed->second->first) {
+    return ResultSlot{indexed->second, true, {}};
+  }
+  auto name = key.str();
+  const auto it = _resultsMap.lower_bound(name);
+  if (it == _resultsMap.end() || it->first != name) {
+    return ResultSlot{it, false, std::move(name)};
+  }
+  // keep the first of two keys whose hashes collide
+  if (indexed == _keyIndex.entries.end()) {
+    _keyIndex.entries.emplace(key.hash(), it);
+  }
+  return ResultSlot{it, true, {}};
 }
 
-void Testcase::assume(const std::string& key, const data_point& value) {
-  _resultsMap.emplace(key, ResultEntry{value, ResultCategory::Assert});
-  _posted = false;
+ResultsMap::iterator Testcase::insert_result(ResultSlot& slot,
+                                             ResultEntry entry) {
+  return _resultsMap.emplace_hint(slot.it, std::move(slot.name),
+                                  std::move(entry));
+}
+
+void Testcase::check(const touca::key& key, data_point value) {
+  detail::arena_scope scope(_arena.get());
+  auto slot = find_result(key);
+  if (!slot.found) {
+    insert_result(slot, ResultEntry{std::move(value), ResultCategory::Check});
+  }
+  invalidate();
+}
+
+void Testcase::assume(const touca::key& key, data_point value) {
+  detail::arena_scope scope(_arena.get());
+  auto slot = find_result(key);
+  if (!slot.found) {
+    insert_result(slot, ResultEntry{std::move(value), ResultCategory::Assert});
+  }
+  invalidate();
+}
+
+void Testcase::add_results(detail::result_list results,
+                           const ResultCategory category) {
+  detail::arena_scope scope(_arena.get());
+  for (auto& result : results) {
+    auto slot = find_result(touca::key(result.first));
+    if (!slot.found) {
+      insert_result(slot, ResultEntry{std::move(result.second), category});
+    }
+  }
+  invalidate();
 }
 
-void Testcase::add_array_element(const std::string& key,
-                                 const data_point& element) {
-  if (!_resultsMap.count(key)) {
-    _resultsMap.emplace(
-        key, ResultEntry{array().add(element), ResultCategory::Check});
+void Testcase::add_array_element(const touca::key& key, data_point element) {
+  detail::arena_scope scope(_arena.get());
+  auto slot = find_result(key);
+  if (!slot.found) {
+    insert_result(slot, ResultEntry{array().add(std::move(element)),
+                                    ResultCategory::Check});
+    invalidate();
     return;
   }
-  auto& ivalue = _resultsMap.at(key);
+  auto& ivalue = slot.it->second;
+  ivalue.val.unpack();
   if (ivalue.val.type() != detail::internal_type::array) {
     throw std::invalid_argument("specified key has a different type");
   }
-  ivalue.val.as_array()->push_back(element);
-  _posted = false;
+  ivalue.val.as_array()->push_back(std::move(element));
+  invalidate();
 }
 
-void Testcase::add_hit_count(const std::string& key) {
-  if (!_resultsMap.count(key)) {
-    _resultsMap.emplace(key, ResultEntry{data_point::number_unsigned(1u),
-                                         ResultCategory::Check});
+void Testcase::add_hit_count(const touca::key& key,
+                             const std::uint64_t count) {
+  auto slot = find_result(key);
+  if (!slot.found) {
+    insert_result(slot, ResultEntry{data_point::number_unsigned(count),
+                                    ResultCategory::Check});
+    invalidate();
     return;
   }
-  auto& ivalue = _resultsMap.at(key);
+  auto& ivalue = slot.it->second;
   if (ivalue.val.type() != detail::internal_type::number_unsigned) {
     throw std::invalid_argument("specified key has a different type");
   }
-  ivalue.val.increment();
-  _posted = false;
+  ivalue.val.increment(count);
+  invalidate();
 }
 
 void Testcase::add_metric(const std::string& key, const unsigned duration) {
@@ -132,7 +234,7 @@ void Testcase::add_metric(const std::string& key, const unsigned duration) {
   const auto& toc = chr::system_clock::time_point(chr::milliseconds(duration));
   _tics.emplace(key, tic);
   _tocs.emplace(key, toc);
-  _posted = false;
+  invalidate();
 }
 
 MetricsMap Testcase::metrics() const {
@@ -182,7 +284,48 @@ nlohmann::ordered_json Testcase::json() const {
                                  {"metrics", json_metrics}});
 }
 
+void Testcase::invalidate() {
+  _posted = false;
+  // the serialized form may still be used by copies of this testcase
+  if (!_serialized || _serialized.use_count() > 1) {
+    _serialized = std::make_shared<Serialized>();
+  } else {
+    _serialized->message.reset();
+  }
+}
+
 std::vector<uint8_t> Testcase::flatbuffers() const {
+  // the caller gets its own copy, so we only use the serialized form if
+  // it is already cached and do not cache it otherwise.
+  if (_serialized) {
+    std::lock_guard<std::mutex> lock(_serialized->mutex);
+    if (_serialized->message) {
+      return *_serialized->message;
+    }
+  }
+  return build_message();
+}
+
+std::shared_ptr<const std::vector<uint8_t>> Testcase::message() const {
+  if (!_serialized) {
+    _serialized = std::make_shared<Serialized>();
+  }
+  std::lock_guard<std::mutex> lock(_serialized->mutex);
+  if (!_serialized->message) {
+    _serialized->message =
+        std::make_shared<const std::vector<uint8_t>>(build_message());
+  }
+  return _serialized->message;
+}
+
+void Testcase::release_message() const {
+  if (_serialized) {
+    std::lock_guard<std::mutex> lock(_serialized->mutex);
+    _serialized->message.reset();
+  }
+}
+
+std::vector<uint8_t> Testcase::build_message() const {
   flatbuffers::FlatBufferBuilder builder;
 
   const auto& fbsTeamslug = builder.CreateString(_metadata.teamslug);
@@ -270,20 +413,66 @@ Testcase::Overview Testcase::overview() const {
 }
 
 void Testcase::clear() {
-  _posted = false;
+  invalidate();
   _resultsMap.clear();
+  _keyIndex.entries.clear();
   _tics.clear();
   _tocs.clear();
+  // the old arena is released once copies of this testcase that may
+  // still hold nodes allocated from it are destroyed.
+  if (_arena) {
+    _arena = std::make_shared<detail::arena>();
+  }
+  _adopted.clear();
 }
 
 std::vector<uint8_t> Testcase::serialize(
     const std::vector<Testcase>& testcases) {
-  flatbuffers::FlatBufferBuilder fbb;
+  std::vector<std::shared_ptr<const std::vector<uint8_t>>> messages;
+  messages.reserve(testcases.size());
+  for (const auto& tc : testcases) {
+    messages.push_back(tc.message());
+    tc.release_message();
+  }
+  return serialize(messages);
+}
 
+std::vector<uint8_t> Testcase::serialize(
+    const std::vector<std::shared_ptr<const std::vector<uint8_t>>>& buffers) {
+  detail::messages_writer writer;
+  writer.write(buffers);
+  return {writer.data(), writer.data() + writer.size()};
+}
+
+namespace detail {
+
+/** space reserved for each testcase in addition to its content */
+constexpr std::size_t message_overhead = 32u;
+
+messages_writer::messages_writer() = default;
+
+messages_writer::~messages_writer() = default;
+
+void messages_writer::write(
+    const std::vector<std::shared_ptr<const std::vector<uint8_t>>>& messages) {
+  auto required = message_overhead;
+  for (const auto& message : messages) {
+    required += message->size() + message_overhead;
+  }
+  // the builder is replaced if it is too small, or if it is much larger
+  // than needed so that one large batch does not hold on to its memory.
+  if (!_builder || _capacity < required || 4u * required < _capacity) {
+    _builder.reset(new flatbuffers::FlatBufferBuilder(required));
+    _capacity = required;
+  } else {
+    _builder->Clear();
+  }
+
+  auto& fbb = *_builder;
   std::vector<flatbuffers::Offset<fbs::MessageBuffer>> fbsMessageBuffer_vector;
-  for (const auto& tc : testcases) {
-    const auto& buffer = tc.flatbuffers();
-    const auto& bufferVec = fbb.CreateVector(buffer);
+  fbsMessageBuffer_vector.reserve(messages.size());
+  for (const auto& message : messages) {
+    const auto& bufferVec = fbb.CreateVector(*message);
     const auto& fbsMessageBuffer = fbs::CreateMessageBuffer(fbb, bufferVec);
     fbsMessageBuffer_vector.push_back(fbsMessageBuffer);
   }
@@ -291,11 +480,18 @@ std::vector<uint8_t> Testcase::serialize(
 
   fbs::MessagesBuilder fbsMessages_builder(fbb);
   fbsMessages_builder.add_messages(fbsMessageBuffers);
-  const auto& messages = fbsMessages_builder.Finish();
-  fbb.Finish(messages);
+  const auto& fbsMessages = fbsMessages_builder.Finish();
+  fbb.Finish(fbsMessages);
+}
 
-  const auto& ptr = fbb.GetBufferPointer();
-  return {ptr, ptr + fbb.GetSize()};
+const uint8_t* messages_writer::data() const {
+  return _builder ? _builder->GetBufferPointer() : nullptr;
 }
 
+std::size_t messages_writer::size() const {
+  return _builder ? _builder->GetSize() : 0u;
+}
+
+}  // namespace detail
+
 }  // namespace touca
@@ -2,10 +2,13 @@
 
 #include "touca/core/types.hpp"
 
+#include <cmath>
+#include <cstring>
 #include <utility>
 
 #include "flatbuffers/flatbuffers.h"
 #include "nlohmann/json.hpp"
+#include "touca/core/serializer.hpp"
 #include "touca/impl/schema.hpp"
 
 namespace touca {
@@ -99,9 +102,9 @@ flatbuffers::Offset<fbs::TypeWrapper> serialize(
 }
 
 flatbuffers::Offset<fbs::TypeWrapper> serialize(
-    flatbuffers::FlatBufferBuilder& builder, const detail::array_t& elements) {
+    flatbuffers::FlatBufferBuilder& builder, const detail::array_node& node) {
   std::vector<flatbuffers::Offset<fbs::TypeWrapper>> fbsEntries_vector;
-  for (const auto& element : elements) {
+  for (const auto& element : node.elements) {
     fbsEntries_vector.push_back(element.serialize(builder));
   }
   const auto& fbsEntries = builder.CreateVector(fbsEntries_vector);
@@ -115,10 +118,9 @@ flatbuffers::Offset<fbs::TypeWrapper> serialize(
 }
 
 flatbuffers::Offset<fbs::TypeWrapper> serialize(
-    flatbuffers::FlatBufferBuilder& builder, const detail::object_t& obj,
-    const std::string& name) {
+    flatbuffers::FlatBufferBuilder& builder, const detail::object_node& obj) {
   std::vector<flatbuffers::Offset<fbs::ObjectMember>> fbsObjectMembers_vector;
-  for (const auto& value : obj) {
+  for (const auto& value : obj.members) {
     const auto& fbsMemberKey = builder.CreateString(value.first);
     const auto& fbsMemberValue = value.second.serialize(builder);
     fbs::ObjectMemberBuilder fbsObjectMember_builder(builder);
@@ -128,7 +130,7 @@ flatbuffers::Offset<fbs::TypeWrapper> serialize(
     fbsObjectMembers_vector.push_back(fbsObjectMember);
   }
   const auto& fbsObjectMembers = builder.CreateVector(fbsObjectMembers_vector);
-  const auto& fbsKey = builder.CreateString(name);
+  const auto& fbsKey = builder.CreateString(obj.name);
   fbs::ObjectBuilder fbsObject_builder(builder);
   fbsObject_builder.add_values(fbsObjectMembers);
   fbsObject_builder.add_key(fbsKey);
@@ -139,10 +141,142 @@ flatbuffers::Offset<fbs::TypeWrapper> serialize(
   return typeWrapper_builder.Finish();
 }
 
+template <typename T, typename Builder>
+flatbuffers::Offset<fbs::TypeWrapper> serialize_packed(
+    flatbuffers::FlatBufferBuilder& builder, const packed_array_t& packed,
+    const fbs::Type type) {
+  const auto& values = packed_traits<T>::values(packed);
+  const auto& fbsValues = builder.CreateVector(values.data(), values.size());
+  Builder fbsArray_builder(builder);
+  fbsArray_builder.add_values(fbsValues);
+  const auto& fbsValue = fbsArray_builder.Finish();
+  fbs::TypeWrapperBuilder typeWrapper_builder(builder);
+  typeWrapper_builder.add_value(fbsValue.Union());
+  typeWrapper_builder.add_value_type(type);
+  return typeWrapper_builder.Finish();
+}
+
+flatbuffers::Offset<fbs::TypeWrapper> serialize(
+    flatbuffers::FlatBufferBuilder& builder, const packed_array_t& packed) {
+  switch (packed.element_type) {
+    case internal_type::number_signed:
+      return serialize_packed<number_signed_t, fbs::IntArrayBuilder>(
+          builder, packed, fbs::Type::IntArray);
+    case internal_type::number_unsigned:
+      return serialize_packed<number_unsigned_t, fbs::UIntArrayBuilder>(
+          builder, packed, fbs::Type::UIntArray);
+    case internal_type::number_float:
+      return serialize_packed<number_float_t, fbs::FloatArrayBuilder>(
+          builder, packed, fbs::Type::FloatArray);
+    default:
+      return serialize_packed<number_double_t, fbs::DoubleArrayBuilder>(
+          builder, packed, fbs::Type::DoubleArray);
+  }
+}
+
+/**
+ * Mixes a value into a fingerprint, using the finalizer of splitmix64
+ * so that structurally similar values get unrelated fingerprints.
+ */
+static fingerprint_t mix(const fingerprint_t seed,
+                         const std::uint64_t value) {
+  auto x = seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+static fingerprint_t mix(const fingerprint_t seed, const string_t& value) {
+  // 64-bit FNV-1a
+  std::uint64_t hash = 0xcbf29ce484222325ull;
+  for (const auto& ch : value) {
+    hash = (hash ^ static_cast<unsigned char>(ch)) * 0x100000001b3ull;
+  }
+  return mix(seed, hash);
+}
+
+/**
+ * Keeps computed fingerprints clear of the values that we reserve for
+ * fingerprints that are not computed yet or never match.
+ */
+static fingerprint_t finish(const fingerprint_t value) {
+  return value <= unmatched_fingerprint ? value + 2u : value;
+}
+
+static fingerprint_t fingerprint_of(const internal_type type,
+                                    const std::uint64_t bits) {
+  return finish(mix(static_cast<fingerprint_t>(type), bits));
+}
+
+static fingerprint_t fingerprint_of(const number_signed_t value) {
+  return fingerprint_of(internal_type::number_signed,
+                        static_cast<std::uint64_t>(value));
+}
+
+static fingerprint_t fingerprint_of(const number_unsigned_t value) {
+  return fingerprint_of(internal_type::number_unsigned, value);
+}
+
+static fingerprint_t fingerprint_of(const number_float_t value) {
+  if (std::isnan(value)) {
+    return unmatched_fingerprint;
+  }
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return fingerprint_of(internal_type::number_float, bits);
+}
+
+static fingerprint_t fingerprint_of(const number_double_t value) {
+  if (std::isnan(value)) {
+    return unmatched_fingerprint;
+  }
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return fingerprint_of(internal_type::number_double, bits);
+}
+
+/**
+ * Combines fingerprints of the elements of an array in a way that does
+ * not depend on whether the array is packed.
+ */
+class array_fingerprint {
+ public:
+  explicit array_fingerprint(const std::size_t size)
+      : _value(mix(static_cast<fingerprint_t>(internal_type::array),
+                   static_cast<std::uint64_t>(size))) {}
+
+  void add(const fingerprint_t element) {
+    if (element == unmatched_fingerprint) {
+      _unmatched = true;
+    }
+    _value = mix(_value, element);
+  }
+
+  fingerprint_t value() const {
+    return _unmatched ? unmatched_fingerprint : finish(_value);
+  }
+
+ private:
+  fingerprint_t _value;
+  bool _unmatched = false;
+};
+
+template <typename T>
+fingerprint_t fingerprint_packed(const packed_array_t& packed) {
+  const auto& values = packed_traits<T>::values(packed);
+  array_fingerprint out(values.size());
+  for (const auto& value : values) {
+    out.add(fingerprint_of(value));
+  }
+  return out.value();
+}
+
 }  // namespace detail
 
+static_assert(sizeof(data_point) <= 2 * sizeof(detail::number_double_t),
+              "data_point should remain a compact tagged value");
+
 void data_point::init_from_other(const data_point& src, bool) {
-  _name = src._name;
   _type = src._type;
 
   switch (_type) {
@@ -175,17 +309,21 @@ void data_point::init_from_other(const data_point& src, bool) {
       break;
 
     case detail::internal_type::array:
-      _array = detail::create<detail::array_t>(*src._array);
+      _array = detail::create<detail::array_node>(*src._array);
       break;
 
     case detail::internal_type::object:
-      _object = detail::create<detail::object_t>(*src._object);
+      _object = detail::create<detail::object_node>(*src._object);
+      break;
+
+    case detail::internal_type::packed_array:
+      _packed_array =
+          detail::create<detail::packed_array_t>(*src._packed_array);
       break;
   }
 }
 
 void data_point::init_from_other(data_point&& src, bool assign) noexcept {
-  _name = std::move(src._name);
   _type = src._type;
 
   switch (_type) {
@@ -224,6 +362,11 @@ void data_point::init_from_other(data_point&& src, bool assign) noexcept {
     case detail::internal_type::object:
       _object = detail::exchange(src._object, (assign ? _object : nullptr));
       break;
+
+    case detail::internal_type::packed_array:
+      _packed_array = detail::exchange(src._packed_array,
+                                       (assign ? _packed_array : nullptr));
+      break;
   }
 }
 
@@ -234,11 +377,15 @@ void data_point::destroy() {
       break;
 
     case detail::internal_type::array:
-      detail::destroy<detail::array_t>(_array);
+      detail::destroy<detail::array_node>(_array);
       break;
 
     case detail::internal_type::object:
-      detail::destroy<detail::object_t>(_object);
+      detail::destroy<detail::object_node>(_object);
+      break;
+
+    case detail::internal_type::packed_array:
+      detail::destroy<detail::packed_array_t>(_packed_array);
       break;
 
     default:
@@ -246,7 +393,108 @@ void data_point::destroy() {
   }
 }
 
-void data_point::increment() noexcept { ++_number_unsigned; }
+void data_point::increment(const detail::number_unsigned_t count) noexcept {
+  _number_unsigned += count;
+}
+
+detail::fingerprint_t data_point::fingerprint() const {
+  switch (_type) {
+    case detail::internal_type::boolean:
+      return detail::fingerprint_of(_type, _boolean ? 1u : 0u);
+    case detail::internal_type::number_signed:
+      return detail::fingerprint_of(_number_signed);
+    case detail::internal_type::number_unsigned:
+      return detail::fingerprint_of(_number_unsigned);
+    case detail::internal_type::number_float:
+      return detail::fingerprint_of(_number_float);
+    case detail::internal_type::number_double:
+      return detail::fingerprint_of(_number_double);
+    case detail::internal_type::string:
+      return detail::finish(
+          detail::mix(static_cast<detail::fingerprint_t>(_type), *_string));
+    // nodes may have been modified since their fingerprint was cached,
+    // and their enclosing nodes would not know. so we always compute
+    // fingerprints from scratch and only cache them for `compare`.
+    case detail::internal_type::array: {
+      detail::array_fingerprint out(_array->elements.size());
+      for (const auto& element : _array->elements) {
+        out.add(element.fingerprint());
+      }
+      _array->fingerprint = out.value();
+      return _array->fingerprint;
+    }
+    case detail::internal_type::packed_array: {
+      switch (_packed_array->element_type) {
+        case detail::internal_type::number_signed:
+          _packed_array->fingerprint =
+              detail::fingerprint_packed<detail::number_signed_t>(
+                  *_packed_array);
+          break;
+        case detail::internal_type::number_unsigned:
+          _packed_array->fingerprint =
+              detail::fingerprint_packed<detail::number_unsigned_t>(
+                  *_packed_array);
+          break;
+        case detail::internal_type::number_float:
+          _packed_array->fingerprint =
+              detail::fingerprint_packed<detail::number_float_t>(
+                  *_packed_array);
+          break;
+        default:
+          _packed_array->fingerprint =
+              detail::fingerprint_packed<detail::number_double_t>(
+                  *_packed_array);
+          break;
+      }
+      return _packed_array->fingerprint;
+    }
+    case detail::internal_type::object: {
+      auto out = detail::mix(static_cast<detail::fingerprint_t>(_type),
+                             _object->members.size());
+      auto unmatched = false;
+      for (const auto& member : _object->members) {
+        const auto value = member.second.fingerprint();
+        unmatched = unmatched || value == detail::unmatched_fingerprint;
+        out = detail::mix(detail::mix(out, member.first), value);
+      }
+      _object->fingerprint =
+          unmatched ? detail::unmatched_fingerprint : detail::finish(out);
+      return _object->fingerprint;
+    }
+    default:
+      // null values are never considered identical by `compare`
+      return detail::unmatched_fingerprint;
+  }
+}
+
+template <typename T>
+static void unpack_values(const detail::packed_array_t& packed, array& out) {
+  for (const auto& value : detail::packed_traits<T>::values(packed)) {
+    out.add(value);
+  }
+}
+
+void data_point::unpack() {
+  if (_type != detail::internal_type::packed_array) {
+    return;
+  }
+  array out;
+  switch (_packed_array->element_type) {
+    case detail::internal_type::number_signed:
+      unpack_values<detail::number_signed_t>(*_packed_array, out);
+      break;
+    case detail::internal_type::number_unsigned:
+      unpack_values<detail::number_unsigned_t>(*_packed_array, out);
+      break;
+    case detail::internal_type::number_float:
+      unpack_values<detail::number_float_t>(*_packed_array, out);
+      break;
+    default:
+      unpack_values<detail::number_double_t>(*_packed_array, out);
+      break;
+  }
+  *this = std::move(out);
+}
 
 flatbuffers::Offset<fbs::TypeWrapper> data_point::serialize(
     flatbuffers::FlatBufferBuilder& builder) const {
@@ -266,7 +514,9 @@ flatbuffers::Offset<fbs::TypeWrapper> data_point::serialize(
     case detail::internal_type::array:
       return detail::serialize(builder, *_array);
     case detail::internal_type::object:
-      return detail::serialize(builder, *_object, _name);
+      return detail::serialize(builder, *_object);
+    case detail::internal_type::packed_array:
+      return detail::serialize(builder, *_packed_array);
     default:
       return detail::serialize(builder, false);
   }
@@ -300,18 +550,44 @@ void to_json(nlohmann::json& out, const data_point& value) {
       break;
     case detail::internal_type::array: {
       out = nlohmann::json::array();
-      for (const auto& element : *value._array) {
+      for (const auto& element : value._array->elements) {
         out.push_back(nlohmann::json(element));
       }
       break;
     }
     case detail::internal_type::object: {
       auto items = nlohmann::ordered_json::object();
-      for (const auto& member : *value._object) {
+      for (const auto& member : value._object->members) {
         items.emplace(member.first, nlohmann::json(member.second));
       }
       out = nlohmann::ordered_json::object();
-      out[value._name] = items;
+      out[value._object->name] = items;
+      break;
+    }
+    case detail::internal_type::packed_array: {
+      out = nlohmann::json::array();
+      switch (value._packed_array->element_type) {
+        case detail::internal_type::number_signed:
+          for (const auto& element : value._packed_array->signed_values) {
+            out.push_back(element);
+          }
+          break;
+        case detail::internal_type::number_unsigned:
+          for (const auto& element : value._packed_array->unsigned_values) {
+            out.push_back(element);
+          }
+          break;
+        case detail::internal_type::number_float:
+          for (const auto& element : value._packed_array->float_values) {
+            out.push_back(element);
+          }
+          break;
+        default:
+          for (const auto& element : value._packed_array->double_values) {
+            out.push_back(element);
+          }
+          break;
+      }
       break;
     }
     default:
@@ -4,6 +4,16 @@
 
 #include <chrono>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TOUCA_HAS_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define TOUCA_HAS_AVX2
+#include <immintrin.h>
+#endif
+
 #include "nlohmann/json.hpp"
 #include "touca/core/filesystem.hpp"
 
@@ -11,9 +21,14 @@ namespace touca {
 
 std::map<std::string, data_point> flatten(const data_point& input) {
   std::map<std::string, data_point> entries;
+  if (input._type == detail::internal_type::packed_array) {
+    auto unpacked = input;
+    unpacked.unpack();
+    return flatten(unpacked);
+  }
   if (input._type == detail::internal_type::array) {
-    for (unsigned i = 0; i < (*input._array).size(); ++i) {
-      const auto& value = (*input._array).at(i);
+    for (unsigned i = 0; i < input._array->elements.size(); ++i) {
+      const auto& value = input._array->elements.at(i);
       const auto& name = '[' + std::to_string(i) + ']';
       const auto& nestedMembers = flatten(value);
       if (nestedMembers.empty()) {
@@ -26,7 +41,7 @@ std::map<std::string, data_point> flatten(const data_point& input) {
       }
     }
   } else if (input._type == detail::internal_type::object) {
-    for (const auto& value : *input._object) {
+    for (const auto& value : input._object->members) {
       const auto& name = value.first;
       const auto& nestedMembers = flatten(value.second);
       if (nestedMembers.empty()) {
@@ -42,14 +57,20 @@ std::map<std::string, data_point> flatten(const data_point& input) {
   return entries;
 }
 
-std::vector<data_point> flatten_array(
-    const std::map<std::string, data_point>& elements) {
-  std::vector<data_point> data_points;
-  data_points.reserve(elements.size());
-  for (const auto& element : elements) {
-    data_points.emplace_back(element.second);
-  }
-  return data_points;
+constexpr double number_threshold = 0.2;
+
+/**
+ * Score of two different numbers: one minus their relative difference
+ * if it is within our threshold and zero otherwise.
+ */
+inline double number_score(const double percent) {
+  return 0.0 < percent && percent < number_threshold ? 1.0 - percent : 0.0;
+}
+
+inline double relative_difference(const double src_value,
+                                  const double dst_value) {
+  return 0.0 == dst_value ? 0.0
+                          : std::fabs((src_value - dst_value) / dst_value);
 }
 
 template <typename T>
@@ -60,27 +81,283 @@ void compare_number(const T& src_number, const T& dst_number,
     cmp.score = 1.0;
     return;
   }
-  const auto threshold = 0.2;
+  const auto threshold = number_threshold;
   const auto src_value = static_cast<double>(src_number);
   const auto dst_value = static_cast<double>(dst_number);
   const auto diff = src_value - dst_value;
-  const auto percent = 0.0 == dst_value ? 0.0 : std::fabs(diff / dst_value);
+  const auto percent = relative_difference(src_value, dst_value);
   const auto& difference = 0.0 == percent || threshold < percent
                                ? std::to_string(std::fabs(diff))
                                : std::to_string(percent * 100.0) + " percent";
-  if (0.0 < percent && percent < threshold) {
-    cmp.score = 1.0 - percent;
-  }
+  cmp.score = number_score(percent);
   const std::string direction = 0 < diff ? "larger" : "smaller";
   cmp.desc.insert("value is " + direction + " by " + difference);
 }
 
-void compare_arrays(const data_point& src, const data_point& dst,
-                    TypeComparison& cmp) {
-  const auto& src_members = flatten_array(flatten(src));
-  const auto& dst_members = flatten_array(flatten(dst));
-  const std::pair<size_t, size_t> minmax =
-      std::minmax(src_members.size(), dst_members.size());
+void compare_values(const data_point& src, const data_point& dst,
+                    TypeComparison& cmp);
+
+namespace detail {
+
+struct node_access {
+  static const array_t& elements(const data_point& value) {
+    return value._array->elements;
+  }
+  static const object_t& members(const data_point& value) {
+    return value._object->members;
+  }
+  static const packed_array_t& packed(const data_point& value) {
+    return *value._packed_array;
+  }
+
+  /**
+   * @return fingerprint of a given data point, as cached on its node by
+   *         the most recent call to `fingerprint` on it or on a node that
+   *         encloses it.
+   */
+  static fingerprint_t cached_fingerprint(const data_point& value) {
+    fingerprint_t cached = 0u;
+    switch (value._type) {
+      case internal_type::array:
+        cached = value._array->fingerprint;
+        break;
+      case internal_type::object:
+        cached = value._object->fingerprint;
+        break;
+      case internal_type::packed_array:
+        cached = value._packed_array->fingerprint;
+        break;
+      default:
+        break;
+    }
+    return cached ? cached : value.fingerprint();
+  }
+};
+
+}  // namespace detail
+
+/**
+ * Checks whether two arrays or objects are identical by their cached
+ * fingerprints, without visiting their elements. Fingerprints are
+ * computed by `compare` before it visits any node.
+ */
+bool identical_nodes(const data_point& src, const data_point& dst) {
+  const auto fingerprint = detail::node_access::cached_fingerprint(src);
+  return fingerprint != detail::unmatched_fingerprint &&
+         fingerprint == detail::node_access::cached_fingerprint(dst);
+}
+
+/**
+ * Packed arrays are a more compact representation of arrays of numbers
+ * and are reported and compared as arrays.
+ */
+detail::internal_type comparable_type(const data_point& value) {
+  return value.type() == detail::internal_type::packed_array
+             ? detail::internal_type::array
+             : value.type();
+}
+
+std::size_t array_size(const data_point& value) {
+  switch (value.type()) {
+    case detail::internal_type::array:
+      return detail::node_access::elements(value).size();
+    case detail::internal_type::packed_array:
+      return detail::node_access::packed(value).size();
+    default:
+      return 0u;
+  }
+}
+
+/**
+ * Refers to an element of an array without copying it. Elements of
+ * packed arrays are materialized as numbers, which does not allocate.
+ */
+class ElementRef {
+ public:
+  ElementRef(const data_point& value, const std::size_t index) {
+    if (value.type() == detail::internal_type::array) {
+      _ptr = &detail::node_access::elements(value).at(index);
+      return;
+    }
+    const auto& packed = detail::node_access::packed(value);
+    switch (packed.element_type) {
+      case detail::internal_type::number_signed:
+        _value = data_point::number_signed(packed.signed_values[index]);
+        break;
+      case detail::internal_type::number_unsigned:
+        _value = data_point::number_unsigned(packed.unsigned_values[index]);
+        break;
+      case detail::internal_type::number_float:
+        _value = data_point::number_float(packed.float_values[index]);
+        break;
+      default:
+        _value = data_point::number_double(packed.double_values[index]);
+        break;
+    }
+  }
+
+  const data_point& get() const { return _ptr ? *_ptr : _value; }
+
+ private:
+  const data_point* _ptr = nullptr;
+  data_point _value = data_point::null();
+};
+
+/**
+ * Outcome of element-wise comparison of the common elements of two
+ * arrays: the sum of the scores of all elements and the indices of the
+ * elements that did not match.
+ */
+struct ElementsComparison {
+  double score = 0.0;
+  std::vector<std::size_t> differences;
+};
+
+/**
+ * @return index of the first element in range `[i, n)` that is different
+ *         in the two given arrays, or `n` if there is no such element.
+ */
+template <typename T>
+std::size_t find_mismatch(const T* src, const T* dst, std::size_t i,
+                          const std::size_t n) {
+  while (i < n && src[i] == dst[i]) {
+    ++i;
+  }
+  return i;
+}
+
+#ifdef TOUCA_HAS_SSE2
+
+/**
+ * Integers are equal if and only if their bytes are equal, so we compare
+ * them as blocks of bytes regardless of their width and signedness.
+ */
+template <typename T>
+std::size_t find_mismatch_integers(const T* src, const T* dst, std::size_t i,
+                                   const std::size_t n) {
+#ifdef TOUCA_HAS_AVX2
+  constexpr std::size_t wide_lanes = sizeof(__m256i) / sizeof(T);
+  for (; i + wide_lanes <= n; i += wide_lanes) {
+    const auto lhs =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    const auto rhs =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs, rhs)) != -1) {
+      break;
+    }
+  }
+#endif
+  constexpr std::size_t lanes = sizeof(__m128i) / sizeof(T);
+  for (; i + lanes <= n; i += lanes) {
+    const auto lhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const auto rhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(lhs, rhs)) != 0xFFFF) {
+      break;
+    }
+  }
+  while (i < n && src[i] == dst[i]) {
+    ++i;
+  }
+  return i;
+}
+
+inline std::size_t find_mismatch(const detail::number_signed_t* src,
+                                 const detail::number_signed_t* dst,
+                                 const std::size_t i, const std::size_t n) {
+  return find_mismatch_integers(src, dst, i, n);
+}
+
+inline std::size_t find_mismatch(const detail::number_unsigned_t* src,
+                                 const detail::number_unsigned_t* dst,
+                                 const std::size_t i, const std::size_t n) {
+  return find_mismatch_integers(src, dst, i, n);
+}
+
+/**
+ * Floating point numbers are compared by value since equal numbers may
+ * have different bits, as is the case for positive and negative zero.
+ */
+inline std::size_t find_mismatch(const detail::number_double_t* src,
+                                 const detail::number_double_t* dst,
+                                 std::size_t i, const std::size_t n) {
+#ifdef TOUCA_HAS_AVX2
+  for (; i + 4 <= n; i += 4) {
+    const auto eq = _mm256_cmp_pd(_mm256_loadu_pd(src + i),
+                                  _mm256_loadu_pd(dst + i), _CMP_EQ_OQ);
+    if (_mm256_movemask_pd(eq) != 0xF) {
+      break;
+    }
+  }
+#endif
+  for (; i + 2 <= n; i += 2) {
+    const auto eq = _mm_cmpeq_pd(_mm_loadu_pd(src + i), _mm_loadu_pd(dst + i));
+    if (_mm_movemask_pd(eq) != 0x3) {
+      break;
+    }
+  }
+  while (i < n && src[i] == dst[i]) {
+    ++i;
+  }
+  return i;
+}
+
+inline std::size_t find_mismatch(const detail::number_float_t* src,
+                                 const detail::number_float_t* dst,
+                                 std::size_t i, const std::size_t n) {
+#ifdef TOUCA_HAS_AVX2
+  for (; i + 8 <= n; i += 8) {
+    const auto eq = _mm256_cmp_ps(_mm256_loadu_ps(src + i),
+                                  _mm256_loadu_ps(dst + i), _CMP_EQ_OQ);
+    if (_mm256_movemask_ps(eq) != 0xFF) {
+      break;
+    }
+  }
+#endif
+  for (; i + 4 <= n; i += 4) {
+    const auto eq = _mm_cmpeq_ps(_mm_loadu_ps(src + i), _mm_loadu_ps(dst + i));
+    if (_mm_movemask_ps(eq) != 0xF) {
+      break;
+    }
+  }
+  while (i < n && src[i] == dst[i]) {
+    ++i;
+  }
+  return i;
+}
+
+#endif
+
+/**
+ * Compares the first `n` elements of two arrays of numbers in one pass.
+ * Runs of identical elements are skipped using vector instructions when
+ * available; only elements that differ are scored individually.
+ */
+template <typename T>
+ElementsComparison compare_numbers(const T* src, const T* dst,
+                                   const std::size_t n) {
+  ElementsComparison out;
+  auto mismatch_score = 0.0;
+  for (auto i = find_mismatch(src, dst, 0u, n); i < n;
+       i = find_mismatch(src, dst, i + 1, n)) {
+    out.differences.push_back(i);
+    mismatch_score += number_score(relative_difference(
+        static_cast<double>(src[i]), static_cast<double>(dst[i])));
+  }
+  out.score = static_cast<double>(n - out.differences.size()) + mismatch_score;
+  return out;
+}
+
+/**
+ * Element-wise comparison of two arrays of given sizes, where
+ * `compare_common` compares their first given number of elements and
+ * `describe` lists the differences of the element at a given index.
+ * Differences are only described if we are going to report them.
+ */
+template <typename Compare, typename Describe>
+void compare_elements(const std::size_t src_size, const std::size_t dst_size,
+                      TypeComparison& cmp, Compare compare_common,
+                      Describe describe) {
+  const std::pair<size_t, size_t> minmax = std::minmax(src_size, dst_size);
 
   // if the two result keys are both empty arrays, we consider them
   // identical. we choose to handle this special case to prevent
@@ -101,117 +378,321 @@ void compare_arrays(const data_point& src, const data_point& dst,
   const auto sizeRatio = diffRange / static_cast<double>(minmax.second);
   // describe the change of array size
   if (0 != diffRange) {
-    const auto& change =
-        src_members.size() < dst_members.size() ? "shrunk" : "grown";
+    const auto& change = src_size < dst_size ? "shrunk" : "grown";
     cmp.desc.insert(touca::detail::format("array size {} by {} elements",
                                           change, diffRange));
   }
   // skip if array size has changed noticeably or if array in head
   // version is empty.
-  if (sizeThreshold < sizeRatio || src_members.empty()) {
+  if (sizeThreshold < sizeRatio || 0u == src_size) {
     // keep match as None and score as 0.0
     // and return the comparison result
-    cmp.dstValue = dst.to_string();
     return;
   }
 
   // perform element-wise comparison
-  auto scoreEarned = 0.0;
-  std::unordered_map<unsigned, std::set<std::string>> differences;
-
-  for (auto i = 0u; i < minmax.first; i++) {
-    const auto tmp = compare(src_members.at(i), dst_members.at(i));
-    scoreEarned += tmp.score;
-    if (MatchType::None == tmp.match) {
-      differences.emplace(i, tmp.desc);
-    }
-  }
+  const auto& common = compare_common(minmax.first);
+  const auto& differences = common.differences;
 
   // we will only report element-wise differences if the number of
   // different elements does not exceed our threshold that determines
   // if this information is helpful to user.
   const auto diffRatioThreshold = 0.2;
   const auto diffSizeThreshold = 10u;
-  const auto diffRatio =
-      differences.size() / static_cast<double>(src_members.size());
+  const auto diffRatio = differences.size() / static_cast<double>(src_size);
   if (diffRatio < diffRatioThreshold ||
       differences.size() < diffSizeThreshold) {
-    for (const auto& diff : differences) {
-      for (const auto& msg : diff.second) {
-        cmp.desc.insert(fmt::format("[{}]:{}", diff.first, msg));
+    for (const auto& index : differences) {
+      for (const auto& msg : describe(index)) {
+        cmp.desc.insert(fmt::format("[{}]:{}", index, msg));
       }
     }
-    cmp.score = scoreEarned / minmax.second;
+    cmp.score = common.score / minmax.second;
   }
 
   if (1.0 == cmp.score) {
     cmp.match = MatchType::Perfect;
-    return;
   }
+}
 
-  cmp.dstValue = dst.to_string();
+/**
+ * Compares two packed arrays of the same element type directly on their
+ * contiguous values, without creating a `data_point` for each element.
+ */
+template <typename T>
+void compare_packed_arrays(const data_point& src, const data_point& dst,
+                           TypeComparison& cmp) {
+  using traits = detail::packed_traits<T>;
+  const auto& src_values = traits::values(detail::node_access::packed(src));
+  const auto& dst_values = traits::values(detail::node_access::packed(dst));
+  compare_elements(
+      src_values.size(), dst_values.size(), cmp,
+      [&src_values, &dst_values](const std::size_t n) {
+        return compare_numbers(src_values.data(), dst_values.data(), n);
+      },
+      [&src_values, &dst_values](const std::size_t i) {
+        TypeComparison tmp;
+        compare_number<T>(src_values[i], dst_values[i], tmp);
+        return tmp.desc;
+      });
 }
 
-void compare_objects(const data_point& src, const data_point& dst,
-                     TypeComparison& cmp) {
-  const auto& src_members = flatten(src);
-  const auto& dst_members = flatten(dst);
-
-  auto scoreEarned = 0.0;
-  auto scoreTotal = 0u;
-  for (const auto& src_member : src_members) {
-    ++scoreTotal;
-    // compare common members
-    if (dst_members.count(src_member.first)) {
-      const auto& dstKey = dst_members.at(src_member.first);
-      const auto& tmp = compare(src_member.second, dstKey);
-      scoreEarned += tmp.score;
-      if (MatchType::Perfect == tmp.match) {
-        continue;
+/**
+ * Compares two objects by walking their trees in lockstep. Leaves are
+ * compared in place and the path to a leaf is only formatted when we
+ * report a difference. Paths and scores are the same as those obtained
+ * by comparing the flattened objects: every leaf counts toward the
+ * score and leaves found on only one side are reported as missing or
+ * new.
+ */
+class TreeComparison {
+ public:
+  explicit TreeComparison(std::set<std::string>& desc) : _desc(desc) {}
+
+  void compare_children(const data_point& src, const data_point& dst) {
+    if (src.type() == detail::internal_type::object &&
+        dst.type() == detail::internal_type::object) {
+      const auto& src_members = detail::node_access::members(src);
+      const auto& dst_members = detail::node_access::members(dst);
+      auto src_it = src_members.begin();
+      auto dst_it = dst_members.begin();
+      while (src_it != src_members.end() || dst_it != dst_members.end()) {
+        if (dst_it == dst_members.end() ||
+            (src_it != src_members.end() && src_it->first < dst_it->first)) {
+          visit_solo(src_it->first, src_it->second, "missing");
+          ++src_it;
+        } else if (src_it == src_members.end() ||
+                   dst_it->first < src_it->first) {
+          visit_solo(dst_it->first, dst_it->second, "new");
+          ++dst_it;
+        } else {
+          push(src_it->first);
+          compare_nodes(src_it->second, dst_it->second);
+          _path.pop_back();
+          ++src_it;
+          ++dst_it;
+        }
       }
-      for (const auto& desc : tmp.desc) {
-        const auto& msg = src_member.first + ": " + desc;
-        cmp.desc.insert(msg);
+      return;
+    }
+    if (comparable_type(src) == detail::internal_type::array &&
+        comparable_type(dst) == detail::internal_type::array) {
+      const auto src_size = array_size(src);
+      const auto dst_size = array_size(dst);
+      for (auto i = 0u; i < (std::max)(src_size, dst_size); ++i) {
+        if (dst_size <= i) {
+          visit_solo(i, ElementRef(src, i).get(), "missing");
+        } else if (src_size <= i) {
+          visit_solo(i, ElementRef(dst, i).get(), "new");
+        } else {
+          push(i);
+          compare_nodes(ElementRef(src, i).get(), ElementRef(dst, i).get());
+          _path.pop_back();
+        }
       }
-      continue;
+      return;
+    }
+    // members of an object never share a path with elements of an array
+    visit_children(src, "missing");
+    visit_children(dst, "new");
+  }
+
+  double score_earned() const { return _earned; }
+
+  double score_total() const { return static_cast<double>(_total); }
+
+ private:
+  struct Segment {
+    const std::string* name;
+    std::size_t index;
+  };
+
+  static std::size_t count_children(const data_point& value) {
+    return value.type() == detail::internal_type::object
+               ? detail::node_access::members(value).size()
+               : array_size(value);
+  }
+
+  void compare_nodes(const data_point& src, const data_point& dst) {
+    const auto src_leaf = 0u == count_children(src);
+    const auto dst_leaf = 0u == count_children(dst);
+    if (src_leaf && dst_leaf) {
+      TypeComparison tmp;
+      compare_values(src, dst, tmp);
+      ++_total;
+      _earned += tmp.score;
+      if (MatchType::Perfect != tmp.match) {
+        const auto& prefix = path();
+        for (const auto& desc : tmp.desc) {
+          _desc.insert(prefix + ": " + desc);
+        }
+      }
+    } else if (src_leaf) {
+      report("missing");
+      visit_children(dst, "new");
+    } else if (dst_leaf) {
+      visit_children(src, "missing");
+      report("new");
+    } else if (identical_nodes(src, dst)) {
+      const auto leaves = count_leaves(src);
+      _total += leaves;
+      _earned += leaves;
+    } else {
+      compare_children(src, dst);
     }
-    // report src members that are missing from dst
-    const auto& msg = src_member.first + ": missing";
-    cmp.desc.insert(msg);
   }
 
-  // report dst members that are missing from src
-  for (const auto& dstMember : dst_members) {
-    if (!src_members.count(dstMember.first)) {
-      const auto& msg = dstMember.first + ": new";
-      cmp.desc.insert(msg);
-      ++scoreTotal;
+  static unsigned count_leaves(const data_point& value) {
+    if (value.type() == detail::internal_type::object) {
+      auto count = 0u;
+      for (const auto& member : detail::node_access::members(value)) {
+        const auto& child = member.second;
+        count += 0u == count_children(child) ? 1u : count_leaves(child);
+      }
+      return count;
+    }
+    if (value.type() != detail::internal_type::array) {
+      return static_cast<unsigned>(array_size(value));
+    }
+    auto count = 0u;
+    for (const auto& element : detail::node_access::elements(value)) {
+      count += 0u == count_children(element) ? 1u : count_leaves(element);
+    }
+    return count;
+  }
+
+  template <typename Key>
+  void visit_solo(const Key& key, const data_point& value,
+                  const char* status) {
+    push(key);
+    if (0u == count_children(value)) {
+      report(status);
+    } else {
+      visit_children(value, status);
+    }
+    _path.pop_back();
+  }
+
+  void visit_children(const data_point& value, const char* status) {
+    if (value.type() == detail::internal_type::object) {
+      for (const auto& member : detail::node_access::members(value)) {
+        visit_solo(member.first, member.second, status);
+      }
+      return;
+    }
+    for (auto i = 0u; i < array_size(value); ++i) {
+      visit_solo(i, ElementRef(value, i).get(), status);
     }
   }
 
+  void push(const std::string& name) { _path.push_back({&name, 0u}); }
+
+  void push(const std::size_t index) { _path.push_back({nullptr, index}); }
+
+  void report(const char* status) {
+    ++_total;
+    _desc.insert(path() + ": " + status);
+  }
+
+  /**
+   * Formats the path to the current node the same way `flatten` forms
+   * its keys: members of objects are separated by a dot and elements of
+   * arrays are appended as their index in brackets.
+   */
+  std::string path() const {
+    std::string out;
+    for (auto i = 0u; i < _path.size(); ++i) {
+      if (0u != i && _path[i - 1].name) {
+        out += '.';
+      }
+      if (_path[i].name) {
+        out += *_path[i].name;
+      } else {
+        out += '[' + std::to_string(_path[i].index) + ']';
+      }
+    }
+    return out;
+  }
+
+  std::set<std::string>& _desc;
+  std::vector<Segment> _path;
+  double _earned = 0.0;
+  unsigned _total = 0u;
+};
+
+/**
+ * Compares two arrays element by element, treating each top-level element
+ * as one unit regardless of how deeply it is nested. Unlike comparing the
+ * flattened leaves of the two arrays, the size threshold applies to the
+ * number of top-level elements, the score is the sum of the scores of the
+ * common elements, each computed recursively, divided by the size of the
+ * larger array, and descriptions of differences are prefixed with the
+ * index of the top-level element they belong to, e.g. `[1]:[2]:...`.
+ */
+void compare_arrays(const data_point& src, const data_point& dst,
+                    TypeComparison& cmp) {
+  if (src.type() == detail::internal_type::packed_array &&
+      dst.type() == detail::internal_type::packed_array &&
+      detail::node_access::packed(src).element_type ==
+          detail::node_access::packed(dst).element_type) {
+    switch (detail::node_access::packed(src).element_type) {
+      case detail::internal_type::number_signed:
+        return compare_packed_arrays<detail::number_signed_t>(src, dst, cmp);
+      case detail::internal_type::number_unsigned:
+        return compare_packed_arrays<detail::number_unsigned_t>(src, dst, cmp);
+      case detail::internal_type::number_float:
+        return compare_packed_arrays<detail::number_float_t>(src, dst, cmp);
+      default:
+        return compare_packed_arrays<detail::number_double_t>(src, dst, cmp);
+    }
+  }
+
+  std::unordered_map<std::size_t, std::set<std::string>> descriptions;
+  compare_elements(
+      array_size(src), array_size(dst), cmp,
+      [&src, &dst, &descriptions](const std::size_t n) {
+        ElementsComparison out;
+        for (auto i = 0u; i < n; i++) {
+          TypeComparison tmp;
+          compare_values(ElementRef(src, i).get(), ElementRef(dst, i).get(),
+                         tmp);
+          out.score += tmp.score;
+          if (MatchType::None == tmp.match) {
+            out.differences.push_back(i);
+            descriptions.emplace(i, std::move(tmp.desc));
+          }
+        }
+        return out;
+      },
+      [&descriptions](const std::size_t i) { return descriptions.at(i); });
+}
+
+void compare_objects(const data_point& src, const data_point& dst,
+                     TypeComparison& cmp) {
+  TreeComparison tree(cmp.desc);
+  tree.compare_children(src, dst);
+
   // report comparison as perfect match if all children match
-  if (scoreEarned == scoreTotal) {
+  if (tree.score_earned() == tree.score_total()) {
     cmp.match = MatchType::Perfect;
     cmp.score = 1.0;
     return;
   }
   // set score as match rate of children
-  cmp.score = scoreEarned / scoreTotal;
+  cmp.score = tree.score_earned() / tree.score_total();
 }
 
-TypeComparison compare(const data_point& src, const data_point& dst) {
-  TypeComparison cmp;
-  cmp.srcType = src._type;
-  cmp.srcValue = src.to_string();
+void compare_values(const data_point& src, const data_point& dst,
+                    TypeComparison& cmp) {
+  cmp.srcType = comparable_type(src);
 
   // the two result keys are considered completely different
   // if they are different in types.
 
-  if (src._type != dst._type) {
-    cmp.dstType = dst._type;
-    cmp.dstValue = dst.to_string();
+  if (cmp.srcType != comparable_type(dst)) {
+    cmp.dstType = comparable_type(dst);
     cmp.desc.insert("result types are different");
-    return cmp;
+    return;
   }
 
   if (src._type == detail::internal_type::boolean) {
@@ -219,47 +700,48 @@ TypeComparison compare(const data_point& src, const data_point& dst) {
     if (src._boolean == dst._boolean) {
       cmp.match = MatchType::Perfect;
       cmp.score = 1.0;
-      return cmp;
     }
-    cmp.dstValue = dst.to_string();
   } else if (src._type == detail::internal_type::number_double) {
     compare_number<detail::number_double_t>(src._number_double,
                                             dst._number_double, cmp);
-    if (cmp.match != MatchType::Perfect) {
-      cmp.dstValue = dst.to_string();
-    }
   } else if (src._type == detail::internal_type::number_float) {
     compare_number<detail::number_float_t>(src._number_float, dst._number_float,
                                            cmp);
-    if (cmp.match != MatchType::Perfect) {
-      cmp.dstValue = dst.to_string();
-    }
   } else if (src._type == detail::internal_type::number_signed) {
     compare_number<detail::number_signed_t>(src._number_signed,
                                             dst._number_signed, cmp);
-    if (cmp.match != MatchType::Perfect) {
-      cmp.dstValue = dst.to_string();
-    }
   } else if (src._type == detail::internal_type::number_unsigned) {
     compare_number<detail::number_unsigned_t>(src._number_unsigned,
                                               dst._number_unsigned, cmp);
-    if (cmp.match != MatchType::Perfect) {
-      cmp.dstValue = dst.to_string();
-    }
   } else if (src._type == detail::internal_type::string) {
     if (0 == src._string->compare(*dst._string)) {
       cmp.match = MatchType::Perfect;
       cmp.score = 1.0;
-    } else {
-      cmp.dstValue = dst.to_string();
     }
-  } else if (src._type == detail::internal_type::array) {
+  } else if (identical_nodes(src, dst)) {
+    cmp.match = MatchType::Perfect;
+    cmp.score = 1.0;
+  } else if (cmp.srcType == detail::internal_type::array) {
     compare_arrays(src, dst, cmp);
   } else if (src._type == detail::internal_type::object) {
     compare_objects(src, dst, cmp);
-    if (cmp.match != MatchType::Perfect) {
-      cmp.dstValue = dst.to_string();
-    }
+  }
+}
+
+TypeComparison compare(const data_point& src, const data_point& dst) {
+  TypeComparison cmp;
+  // results may have been modified since they were last compared, so we
+  // refresh fingerprints of all their nodes once, before visiting them.
+  src.fingerprint();
+  dst.fingerprint();
+  compare_values(src, dst, cmp);
+  cmp.srcValue = src.to_string();
+  // we describe the destination value only if it differs from the source.
+  // two null values are neither a match nor described.
+  if (MatchType::Perfect != cmp.match &&
+      (detail::internal_type::null != cmp.srcType ||
+       detail::internal_type::unknown != cmp.dstType)) {
+    cmp.dstValue = dst.to_string();
   }
   return cmp;
 }
@@ -276,6 +758,7 @@ std::string Cellar::stringify(const detail::internal_type type) const {
     case detail::internal_type::string:
       return "string";
     case detail::internal_type::array:
+    case detail::internal_type::packed_array:
       return "array";
     case detail::internal_type::object:
       return "object";
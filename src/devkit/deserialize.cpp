@@ -11,6 +11,18 @@
 
 namespace touca {
 
+template <typename T, typename Table>
+data_point deserialize_packed(const void* value) {
+  using traits = detail::packed_traits<T>;
+  const auto& fbsValues = static_cast<const Table*>(value)->values();
+  detail::packed_array_t out(traits::type);
+  if (fbsValues) {
+    traits::values(out).assign(fbsValues->data(),
+                               fbsValues->data() + fbsValues->size());
+  }
+  return out;
+}
+
 data_point deserialize_value(const fbs::TypeWrapper* ptr) {
   const auto& value = ptr->value();
   const auto& type = ptr->value_type();
@@ -47,6 +59,17 @@ data_point deserialize_value(const fbs::TypeWrapper* ptr) {
       }
       return out;
     }
+    case fbs::Type::IntArray:
+      return deserialize_packed<detail::number_signed_t, fbs::IntArray>(value);
+    case fbs::Type::UIntArray:
+      return deserialize_packed<detail::number_unsigned_t, fbs::UIntArray>(
+          value);
+    case fbs::Type::FloatArray:
+      return deserialize_packed<detail::number_float_t, fbs::FloatArray>(
+          value);
+    case fbs::Type::DoubleArray:
+      return deserialize_packed<detail::number_double_t, fbs::DoubleArray>(
+          value);
     case fbs::Type::Object: {
       const auto& fbsObj = static_cast<const fbs::Object*>(value);
       touca::object out(fbsObj->key()->data());
@@ -2,15 +2,90 @@
 
 #include "touca/devkit/platform.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <mutex>
+#include <random>
 #include <regex>
 #include <sstream>
+#include <thread>
+#include <utility>
 
 #include "httplib.h"
 #include "nlohmann/json.hpp"
 #include "touca/core/filesystem.hpp"
 
+#ifdef TOUCA_ZLIB_SUPPORT
+#include "zlib.h"
+#endif
+
 namespace touca {
 
+#ifdef TOUCA_ZLIB_SUPPORT
+/**
+ * Compresses given content in gzip format.
+ *
+ * @return compressed content, or an empty buffer if the content could
+ *         not be compressed.
+ */
+static std::vector<uint8_t> gzip(const uint8_t* content,
+                                 const std::size_t size,
+                                 const unsigned level) {
+  std::vector<uint8_t> output;
+  if (static_cast<uInt>(size) != size) {
+    return output;
+  }
+  z_stream stream{};
+  // adding 16 to window bits makes zlib write a gzip header and trailer
+  if (deflateInit2(&stream, static_cast<int>(level), Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return output;
+  }
+  output.resize(deflateBound(&stream, static_cast<uLong>(size)));
+  stream.next_in = const_cast<Bytef*>(content);
+  stream.avail_in = static_cast<uInt>(size);
+  stream.next_out = output.data();
+  stream.avail_out = static_cast<uInt>(output.size());
+  const auto status = deflate(&stream, Z_FINISH);
+  output.resize(status == Z_STREAM_END ? stream.total_out : 0u);
+  deflateEnd(&stream);
+  return output;
+}
+#endif
+
+/**
+ * Checks if content of requests can be compressed using a given content
+ * coding. An empty content coding stands for no compression.
+ */
+static bool supports_encoding(const std::string& encoding) {
+#ifdef TOUCA_ZLIB_SUPPORT
+  if (encoding == "gzip") {
+    return true;
+  }
+#endif
+  return encoding.empty();
+}
+
+/**
+ * Checks if a given value of header `Accept-Encoding`, such as
+ * `gzip, br;q=0.5`, includes a given content coding.
+ */
+static bool accepts_encoding(const std::string& accepted,
+                             const std::string& encoding) {
+  std::istringstream stream(accepted);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    item = item.substr(0, item.find(';'));
+    item.erase(0, item.find_first_not_of(' '));
+    item.erase(item.find_last_not_of(' ') + 1);
+    if (item == encoding) {
+      return true;
+    }
+  }
+  return false;
+}
+
 class Http : public Transport {
  public:
   explicit Http(const std::string& root);
@@ -19,6 +94,8 @@ class Http : public Transport {
   Response patch(const std::string& route, const std::string& body = "") const;
   Response post(const std::string& route, const std::string& body = "") const;
   Response binary(const std::string& route, const std::string& content) const;
+  Response binary(const std::string& route, const uint8_t* content,
+                  const std::size_t size, const std::string& encoding) const;
 
  private:
   mutable httplib::Client _cli;
@@ -28,6 +105,7 @@ Http::Http(const std::string& root) : _cli(root.c_str()) {
   _cli.set_default_headers({{"Accept-Charset", "utf-8"},
                             {"Accept", "application/json"},
                             {"User-Agent", "touca-client-cpp/1.5.2"}});
+  _cli.set_keep_alive(true);
 #ifdef CPPHTTPLIB_OPENSSL_SUPPORT
   _cli.enable_server_certificate_verification(false);
 #endif
@@ -43,7 +121,8 @@ Response Http::get(const std::string& route) const {
     return {-1, touca::detail::format("failed to submit HTTP GET request to {}",
                                       route)};
   }
-  return {result->status, result->body};
+  return {result->status, result->body,
+          result->get_header_value("Accept-Encoding")};
 }
 
 Response Http::patch(const std::string& route, const std::string& body) const {
@@ -66,13 +145,137 @@ Response Http::post(const std::string& route, const std::string& body) const {
 
 Response Http::binary(const std::string& route,
                       const std::string& content) const {
-  const auto& result =
-      _cli.Post(route.c_str(), content, "application/octet-stream");
+  return binary(route, reinterpret_cast<const uint8_t*>(content.data()),
+                content.size(), "");
+}
+
+Response Http::binary(const std::string& route, const uint8_t* content,
+                      const std::size_t size,
+                      const std::string& encoding) const {
+  httplib::Headers headers;
+  if (!encoding.empty()) {
+    headers.emplace("Content-Encoding", encoding);
+  }
+  // content is streamed from the given buffer, rather than copied into
+  // the body of the request.
+  const auto& result = _cli.Post(
+      route.c_str(), headers, size,
+      [content](size_t offset, size_t length, httplib::DataSink& sink) {
+        sink.write(reinterpret_cast<const char*>(content) + offset, length);
+        return true;
+      },
+      "application/octet-stream");
   if (!result) {
     return {-1, touca::detail::format(
                     "failed to submit HTTP POST request to {}", route)};
   }
-  return {result->status, result->body};
+  return {result->status, result->body, "",
+          result->get_header_value("Retry-After")};
+}
+
+/**
+ * Transport that performs each request over one of a pool of persistent
+ * connections, so that it can be shared by multiple threads and perform
+ * multiple requests at the same time. Connections are created as needed
+ * and kept open once their request is performed.
+ */
+class HttpPool : public Transport {
+ public:
+  explicit HttpPool(const std::string& root);
+  void set_token(const std::string& token);
+  Response get(const std::string& route) const;
+  Response patch(const std::string& route, const std::string& body = "") const;
+  Response post(const std::string& route, const std::string& body = "") const;
+  Response binary(const std::string& route, const std::string& content) const;
+  Response binary(const std::string& route, const uint8_t* content,
+                  const std::size_t size, const std::string& encoding) const;
+  std::future<Response> binary_async(const std::string& route,
+                                     const uint8_t* content,
+                                     const std::size_t size,
+                                     const std::string& encoding) const;
+
+ private:
+  Response perform(const std::function<Response(const Http&)>& request) const;
+
+  std::string _root;
+  mutable std::mutex _mutex;
+  std::string _token;
+  mutable std::vector<std::unique_ptr<Http>> _idle;
+};
+
+HttpPool::HttpPool(const std::string& root) : _root(root) {}
+
+void HttpPool::set_token(const std::string& token) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _token = token;
+  for (const auto& http : _idle) {
+    http->set_token(token);
+  }
+}
+
+Response HttpPool::perform(
+    const std::function<Response(const Http&)>& request) const {
+  std::unique_ptr<Http> http;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_idle.empty()) {
+      http = std::move(_idle.back());
+      _idle.pop_back();
+    } else {
+      http.reset(new Http(_root));
+      if (!_token.empty()) {
+        http->set_token(_token);
+      }
+    }
+  }
+  const auto& response = request(*http);
+  std::lock_guard<std::mutex> lock(_mutex);
+  // the token may have been renewed while the request was performed
+  if (!_token.empty()) {
+    http->set_token(_token);
+  }
+  _idle.push_back(std::move(http));
+  return response;
+}
+
+Response HttpPool::get(const std::string& route) const {
+  return perform([&route](const Http& http) { return http.get(route); });
+}
+
+Response HttpPool::patch(const std::string& route,
+                         const std::string& body) const {
+  return perform(
+      [&route, &body](const Http& http) { return http.patch(route, body); });
+}
+
+Response HttpPool::post(const std::string& route,
+                        const std::string& body) const {
+  return perform(
+      [&route, &body](const Http& http) { return http.post(route, body); });
+}
+
+Response HttpPool::binary(const std::string& route,
+                          const std::string& content) const {
+  return perform([&route, &content](const Http& http) {
+    return http.binary(route, content);
+  });
+}
+
+Response HttpPool::binary(const std::string& route, const uint8_t* content,
+                          const std::size_t size,
+                          const std::string& encoding) const {
+  return perform([&route, content, size, &encoding](const Http& http) {
+    return http.binary(route, content, size, encoding);
+  });
+}
+
+std::future<Response> HttpPool::binary_async(
+    const std::string& route, const uint8_t* content, const std::size_t size,
+    const std::string& encoding) const {
+  return std::async(std::launch::async,
+                    [this, route, content, size, encoding]() {
+                      return binary(route, content, size, encoding);
+                    });
 }
 
 ApiUrl::ApiUrl(const std::string& url) {
@@ -162,7 +365,90 @@ bool ApiUrl::confirm(const std::string& team, const std::string& suite,
   return true;
 }
 
-Platform::Platform(const ApiUrl& api) : _api(api), _http(new Http(api.root())) {
+/**
+ * Loads data cached in a given file.
+ *
+ * @return cached data, or an empty object if the file does not exist or
+ *         is not valid.
+ */
+static nlohmann::json read_cache(const touca::filesystem::path& path) {
+  std::error_code ec;
+  if (!touca::filesystem::is_regular_file(path, ec)) {
+    return nlohmann::json::object();
+  }
+  try {
+    const auto& parsed = nlohmann::json::parse(
+        touca::detail::load_string_file(path.string()), nullptr, false);
+    return parsed.is_object() ? parsed : nlohmann::json::object();
+  } catch (const std::exception&) {
+    return nlohmann::json::object();
+  }
+}
+
+/**
+ * Caches an entry of data in a given file that holds only that entry.
+ * The cache is written to a temporary file that then replaces it, so
+ * that processes reading the cache at the same time never find it
+ * partially written, and processes writing other entries at the same
+ * time do not overwrite this one. Failure to update the cache is
+ * ignored.
+ */
+static void write_cache(const touca::filesystem::path& path,
+                        const std::string& key, nlohmann::json value) {
+  auto cache = nlohmann::json::object();
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  value["time"] =
+      std::chrono::duration_cast<std::chrono::seconds>(now).count();
+  cache[key] = std::move(value);
+  const auto tmp =
+      touca::detail::format("{}.{}", path.string(), std::random_device{}());
+  std::error_code ec;
+  try {
+    // the cache holds API tokens, so it is only readable by its owner.
+    touca::detail::save_string_file(tmp, "");
+    touca::filesystem::permissions(
+        tmp,
+        touca::filesystem::perms::owner_read |
+            touca::filesystem::perms::owner_write,
+        ec);
+    touca::detail::save_string_file(tmp, cache.dump());
+  } catch (const std::exception&) {
+    touca::filesystem::remove(tmp, ec);
+    return;
+  }
+  touca::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    touca::filesystem::remove(tmp, ec);
+  }
+}
+
+/**
+ * Finds an entry of cached data that was cached less than a given
+ * duration ago.
+ *
+ * @return the entry, or `nullptr` if there is no such entry.
+ */
+static const nlohmann::json* find_cached(const nlohmann::json& cache,
+                                         const std::string& key,
+                                         const std::chrono::seconds ttl) {
+  const auto& entry = cache.find(key);
+  if (entry == cache.end() || !entry->is_object() ||
+      !entry->contains("time") || !entry->at("time").is_number_integer()) {
+    return nullptr;
+  }
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  const auto age = std::chrono::duration_cast<std::chrono::seconds>(now) -
+                   std::chrono::seconds(entry->at("time").get<int64_t>());
+  if (age < std::chrono::seconds(0) || ttl <= age) {
+    return nullptr;
+  }
+  return &*entry;
+}
+
+Platform::Platform(const ApiUrl& api)
+    : _api(api),
+      _http(new HttpPool(api.root())),
+      _retry_tokens(_retry_policy.budget) {
   if (!_api._error.empty()) {
     _error = _api._error;
   }
@@ -206,16 +492,70 @@ bool Platform::handshake() const {
     _error = "server is not ready";
     return false;
   }
+  _accept_encoding = response.accept_encoding;
   return true;
 }
 
+std::string Platform::compress(const unsigned level) {
+  if (level != 0u && accepts_encoding(_accept_encoding, "gzip") &&
+      supports_encoding("gzip")) {
+    _encoding = "gzip";
+    _level = (std::min)(level, 9u);
+    return _encoding;
+  }
+  _encoding.clear();
+  _level = 0u;
+  return "";
+}
+
+void Platform::set_cache(const std::string& dir,
+                         const std::chrono::seconds ttl) {
+  _cache_dir = dir;
+  _cache_ttl = ttl;
+}
+
+std::string Platform::cache_path(const std::string& entry) const {
+  const auto& name = touca::detail::format(
+      "{}-{}-{:016x}-{}.json", _api._team, _api._suite,
+      std::hash<std::string>{}(_api.route("")), entry);
+  return (touca::filesystem::path(_cache_dir) / name).string();
+}
+
 /**
- * Submit authentication request. If the server accepts this request,
- * parse the response to extract the API Token issued by the server.
+ * Uses an API Token issued for the same API Key, if one is cached, or
+ * requests a new one from the server.
  */
 bool Platform::auth(const std::string& apiKey) {
   _error.clear();
-  const auto content = touca::detail::format("{{\"key\": \"{}\"}}", apiKey);
+  _api_key = apiKey;
+  const auto& fingerprint =
+      touca::detail::format("{:016x}", std::hash<std::string>{}(apiKey));
+  if (!_cache_dir.empty()) {
+    const auto& cache = read_cache(cache_path("token"));
+    const auto entry = find_cached(cache, "token", _cache_ttl);
+    if (entry && entry->value("key", "") == fingerprint &&
+        entry->contains("value") && entry->at("value").is_string()) {
+      _http->set_token(entry->at("value").get<std::string>());
+      std::lock_guard<std::mutex> lock(_token_mutex);
+      _token_cached = true;
+      _is_auth = true;
+      return true;
+    }
+  }
+  if (!signin()) {
+    return false;
+  }
+  _is_auth = true;
+  return true;
+}
+
+/**
+ * Submit authentication request. If the server accepts this request,
+ * parse the response to extract the API Token issued by the server.
+ */
+bool Platform::signin() const {
+  const auto content =
+      touca::detail::format("{{\"key\": \"{}\"}}", _api_key);
   const auto response = _http->post(_api.route("/client/signin"), content);
   if (response.status == -1) {
     _error = response.body;
@@ -235,16 +575,62 @@ bool Platform::auth(const std::string& apiKey) {
     _error = "unexpected server response";
     return false;
   }
-  _http->set_token(parsed["token"].get<std::string>());
-  _is_auth = true;
+  const auto& token = parsed["token"].get<std::string>();
+  _http->set_token(token);
+  if (!_cache_dir.empty()) {
+    const auto& fingerprint =
+        touca::detail::format("{:016x}", std::hash<std::string>{}(_api_key));
+    write_cache(cache_path("token"), "token",
+                {{"key", fingerprint}, {"value", token}});
+  }
   return true;
 }
 
+/**
+ * Replaces an API token read from the cache, which the server may have
+ * revoked since, with a new token. The token is renewed at most once, by
+ * whichever thread first finds it rejected.
+ *
+ * @return true if the token was renewed.
+ */
+bool Platform::renew_token() const {
+  std::lock_guard<std::mutex> lock(_token_mutex);
+  if (_token_cached) {
+    _token_cached = false;
+    _token_renewed = signin();
+  }
+  return _token_renewed;
+}
+
+Response Platform::reauthorize(const Response& response,
+                               const std::function<Response()>& request) const {
+  if (response.status == 401 && renew_token()) {
+    return request();
+  }
+  return response;
+}
+
 std::vector<std::string> Platform::elements() const {
   _error.clear();
-  const auto& route =
-      touca::detail::format("/client/element/{}/{}", _api._team, _api._suite);
-  const auto& response = _http->get(_api.route(route));
+  if (!_cache_dir.empty()) {
+    const auto& cache = read_cache(cache_path("elements"));
+    const auto entry = find_cached(cache, "elements", _cache_ttl);
+    if (entry && entry->contains("value") && entry->at("value").is_array()) {
+      std::vector<std::string> elements;
+      for (const auto& element : entry->at("value")) {
+        if (element.is_string()) {
+          elements.emplace_back(element.get<std::string>());
+        }
+      }
+      if (!elements.empty()) {
+        return elements;
+      }
+    }
+  }
+  const auto& route = _api.route(
+      touca::detail::format("/client/element/{}/{}", _api._team, _api._suite));
+  const auto get = [this, &route]() { return _http->get(route); };
+  const auto& response = reauthorize(get(), get);
   if (response.status == -1) {
     _error = response.body;
     return {};
@@ -268,31 +654,178 @@ std::vector<std::string> Platform::elements() const {
   }
   if (elements.empty()) {
     _error = "suite has no test case";
+  } else if (!_cache_dir.empty()) {
+    write_cache(cache_path("elements"), "elements", {{"value", elements}});
   }
   return elements;
 }
 
 std::vector<std::string> Platform::submit(const std::string& content,
                                           const unsigned max_retries) const {
-  std::vector<std::string> errors;
-  for (auto i = 0ul; i < max_retries; ++i) {
-    const auto response = _http->binary(_api.route("/client/submit"), content);
-    if (response.status == 204) {
-      return {};
+  return submit(reinterpret_cast<const uint8_t*>(content.data()),
+                content.size(), max_retries);
+}
+
+std::vector<std::string> Platform::submit(const uint8_t* content,
+                                          const std::size_t size,
+                                          const unsigned max_retries) const {
+  return submit_async(content, size, max_retries).get();
+}
+
+/**
+ * The first attempt is started right away and performed in the
+ * background by the transport. Any further attempts are only needed
+ * if the first one fails, and are performed by the thread that waits
+ * for the outcome, after backing off as instructed by the retry policy.
+ * Content is compressed once, before the first attempt, and the same
+ * compressed content is sent by every attempt.
+ */
+std::future<std::vector<std::string>> Platform::submit_async(
+    const uint8_t* content, const std::size_t size,
+    const unsigned max_retries) const {
+  using std::chrono::steady_clock;
+  const auto route = _api.route("/client/submit");
+  const auto started = steady_clock::now();
+  auto data = content;
+  auto length = size;
+  std::string encoding;
+  std::shared_ptr<std::vector<uint8_t>> compressed;
+#ifdef TOUCA_ZLIB_SUPPORT
+  if (_encoding == "gzip") {
+    compressed = std::make_shared<std::vector<uint8_t>>(
+        gzip(content, size, _level));
+  }
+  // content that could not be compressed is submitted as is
+  if (compressed && !compressed->empty()) {
+    data = compressed->data();
+    length = compressed->size();
+    encoding = _encoding;
+  }
+#endif
+  const auto first =
+      _http->binary_async(route, data, length, encoding).share();
+  const auto submit = [this, first, started, route, data, length, encoding,
+                       compressed,
+                       max_retries]() -> std::vector<std::string> {
+    std::vector<std::string> errors;
+    for (auto i = 0u; i < max_retries; ++i) {
+      const auto tic = i == 0u ? started : steady_clock::now();
+      const auto resend = [this, &route, data, length, &encoding]() {
+        return _http->binary(route, data, length, encoding);
+      };
+      const auto response =
+          reauthorize(i == 0u ? first.get() : resend(), resend);
+      const auto latency =
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              steady_clock::now() - tic);
+      record(latency, i != 0u, response.status == 204);
+      if (response.status == 204) {
+        return {};
+      }
+      errors.emplace_back(touca::detail::format(
+          "failed to post testresults for a group of testcases ({}/{})", i + 1,
+          max_retries));
+      if (i + 1u == max_retries) {
+        break;
+      }
+      std::chrono::milliseconds delay;
+      std::string reason;
+      if (!next_retry(response, i, delay, reason)) {
+        errors.emplace_back(reason);
+        break;
+      }
+      std::this_thread::sleep_for(delay);
     }
-    errors.emplace_back(touca::detail::format(
-        "failed to post testresults for a group of testcases ({}/{})", i + 1,
-        max_retries));
+    errors.emplace_back("giving up on submitting testresults");
+    std::lock_guard<std::mutex> lock(_submit_mutex);
+    ++_submit_stats.failures;
+    return errors;
+  };
+  return std::async(std::launch::deferred, submit);
+}
+
+void Platform::set_retry_policy(const RetryPolicy& policy) {
+  std::lock_guard<std::mutex> lock(_submit_mutex);
+  _retry_policy = policy;
+  _retry_tokens = policy.budget;
+}
+
+SubmitStats Platform::submit_stats() const {
+  std::lock_guard<std::mutex> lock(_submit_mutex);
+  return _submit_stats;
+}
+
+/**
+ * Decides whether a failed request should be retried and, if so, how
+ * long to wait before retrying it. Requests are only retried if the
+ * server could not be reached, or if it reported an error that may be
+ * temporary.
+ */
+bool Platform::next_retry(const Response& response, const unsigned attempt,
+                          std::chrono::milliseconds& delay,
+                          std::string& reason) const {
+  const auto status = response.status;
+  if (status != -1 && status != 408 && status != 429 && status < 500) {
+    reason = touca::detail::format("server rejected testresults: {}", status);
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(_submit_mutex);
+  const auto& policy = _retry_policy;
+  if (_retry_tokens < 1.0) {
+    reason = "exhausted the budget for retrying submissions";
+    return false;
+  }
+  // full jitter: wait a random duration up to an exponentially growing
+  // bound, so that concurrent submissions do not retry all at once.
+  auto bound = policy.base_delay;
+  for (auto i = 0u; i < attempt && bound < policy.max_delay; ++i) {
+    bound *= 2;
+  }
+  bound = (std::min)(bound, policy.max_delay);
+  static thread_local std::mt19937 engine{std::random_device{}()};
+  std::uniform_int_distribution<std::chrono::milliseconds::rep> jitter(
+      0, bound.count());
+  delay = std::chrono::milliseconds(jitter(engine));
+  // we only support the form of `Retry-After` that specifies a number of
+  // seconds, and fall back to our own delay for the HTTP-date form.
+  const auto& retry_after = response.retry_after;
+  if (!retry_after.empty() && retry_after.size() < 10u &&
+      std::all_of(retry_after.begin(), retry_after.end(),
+                  [](const char c) {
+                    return std::isdigit(static_cast<unsigned char>(c)) != 0;
+                  })) {
+    const auto requested = std::chrono::seconds(std::stoul(retry_after));
+    if (policy.max_delay < requested) {
+      reason = touca::detail::format(
+          "server asked to retry submission after {} seconds",
+          requested.count());
+      return false;
+    }
+    delay += requested;
+  }
+  _retry_tokens -= 1.0;
+  return true;
+}
+
+void Platform::record(const std::chrono::milliseconds latency,
+                      const bool retry, const bool accepted) const {
+  std::lock_guard<std::mutex> lock(_submit_mutex);
+  ++_submit_stats.requests;
+  _submit_stats.retries += retry ? 1u : 0u;
+  _submit_stats.latency += latency;
+  _submit_stats.max_latency = (std::max)(_submit_stats.max_latency, latency);
+  if (accepted) {
+    _retry_tokens = (std::min)(_retry_tokens + 0.1,
+                               static_cast<double>(_retry_policy.budget));
   }
-  errors.emplace_back("giving up on submitting testresults");
-  return errors;
 }
 
 bool Platform::seal() const {
   _error.clear();
-  const auto route = fmt::format("/batch/{}/{}/{}/seal2", _api._team,
-                                 _api._suite, _api._revision);
-  const auto& response = _http->post(_api.route(route));
+  const auto route = _api.route(fmt::format(
+      "/batch/{}/{}/{}/seal2", _api._team, _api._suite, _api._revision));
+  const auto post = [this, &route]() { return _http->post(route); };
+  const auto& response = reauthorize(post(), post);
   if (response.status == -1) {
     _error = response.body;
     return false;
@@ -69,15 +69,29 @@ void ResultFile::load() { _testcases = parse(); }
 bool ResultFile::isLoaded() const { return !_testcases.empty(); }
 
 void ResultFile::save() {
-  std::vector<Testcase> tcs;
+  // loaded testcases are serialized in place rather than copied, and
+  // are kept as they are instead of being parsed again from the file.
+  std::vector<std::shared_ptr<const std::vector<uint8_t>>> messages;
+  messages.reserve(_testcases.size());
   for (const auto& testcase : _testcases) {
-    tcs.emplace_back(*testcase.second);
+    messages.push_back(testcase.second->message());
+    testcase.second->release_message();
   }
-  return save(tcs);
+  detail::messages_writer writer;
+  writer.write(messages);
+  detail::save_binary_file(_path.string(), writer.data(), writer.size());
 }
 
 void ResultFile::save(const std::vector<Testcase>& testcases) {
-  detail::save_binary_file(_path.string(), Testcase::serialize(testcases));
+  std::vector<std::shared_ptr<const std::vector<uint8_t>>> messages;
+  messages.reserve(testcases.size());
+  for (const auto& testcase : testcases) {
+    messages.push_back(testcase.message());
+    testcase.release_message();
+  }
+  detail::messages_writer writer;
+  writer.write(messages);
+  detail::save_binary_file(_path.string(), writer.data(), writer.size());
   // update map of stored testcases so that it only contains entries
   // for the new testcases we used for saving the file
   load();
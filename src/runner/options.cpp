@@ -67,6 +67,24 @@ cxxopts::Options cli_options() {
       ("overwrite",
           "overwrite result directory for testcase if it already exists",
           cxxopts::value<bool>()->implicit_value("true"))
+      ("async-post",
+          "submit results to Touca server in the background",
+          cxxopts::value<bool>()->implicit_value("true"))
+      ("post-batch-bytes",
+          "target size of each request that submits results, in bytes",
+          cxxopts::value<unsigned>())
+      ("post-concurrency",
+          "maximum number of concurrent requests that submit results",
+          cxxopts::value<unsigned>())
+      ("compression-level",
+          "compress submitted results at given level, from 1 to 9",
+          cxxopts::value<unsigned>())
+      ("cache-dir",
+          "directory to cache API token and list of testcases in",
+          cxxopts::value<std::string>())
+      ("cache-ttl",
+          "number of seconds for which cached data is used",
+          cxxopts::value<unsigned>())
       ("colored-output",
           "use color in standard output",
           cxxopts::value<bool>()->default_value("true"));
@@ -126,6 +144,12 @@ bool parse_cli_options(int argc, char* argv[], FrameworkOptions& options) {
     parse_cli_option(result, "skip-logs", options.skip_logs);
     parse_cli_option(result, "offline", options.offline);
     parse_cli_option(result, "overwrite", options.overwrite);
+    parse_cli_option(result, "async-post", options.async_post);
+    parse_cli_option(result, "post-batch-bytes", options.post_batch_bytes);
+    parse_cli_option(result, "post-concurrency", options.post_concurrency);
+    parse_cli_option(result, "compression-level", options.compression_level);
+    parse_cli_option(result, "cache-dir", options.cache_dir);
+    parse_cli_option(result, "cache-ttl", options.cache_ttl);
   } catch (const cxxopts::OptionParseException& ex) {
     touca::print_error("failed to parse command line arguments: {}\n",
                        ex.what());
@@ -194,6 +218,14 @@ bool parse_file_options(FrameworkOptions& options) {
       parse_file_option(result, "api-url", options.api_url);
       parse_file_option(result, "offline", options.offline);
       parse_file_option(result, "single-thread", options.single_thread);
+      parse_file_option(result, "arena", options.arena);
+      parse_file_option(result, "async-post", options.async_post);
+      parse_file_option(result, "post-batch-bytes", options.post_batch_bytes);
+      parse_file_option(result, "post-concurrency", options.post_concurrency);
+      parse_file_option(result, "compression-level",
+                        options.compression_level);
+      parse_file_option(result, "cache-dir", options.cache_dir);
+      parse_file_option(result, "cache-ttl", options.cache_ttl);
 
       parse_file_option(result, "config-file", options.config_file);
       parse_file_option(result, "output-dir", options.output_dir);
@@ -359,6 +359,13 @@ int Runner::run(const Runner::Workflow workflow) {
   if (_meta.config) {
     _meta.config(options);
   }
+
+  // testcases that are known locally are resolved before configuring the
+  // client, so that it authenticates to the server in the background
+  // while we execute them.
+  if (options.testcases.empty() && !options.testcase_file.empty()) {
+    options.testcases = touca::get_testsuite_local(options.testcase_file);
+  }
   touca::configure(options);
 
   // check that the client is properly configured
@@ -369,11 +376,10 @@ int Runner::run(const Runner::Workflow workflow) {
   }
   logger.info("configured touca client");
 
-  if (options.testcases.empty() && !options.testcase_file.empty()) {
-    options.testcases = touca::get_testsuite_local(options.testcase_file);
-  }
+  // otherwise, the client has already retrieved the list of testcases
+  // from the server during its configuration.
   if (options.testcases.empty() && !options.offline) {
-    options.testcases = touca::get_testsuite_remote(options);
+    options.testcases = touca::get_testcases();
   }
   if (options.testcases.empty()) {
     logger.error("unable to proceed with empty list of testcases");
@@ -2,13 +2,36 @@
 
 #include "touca/client/detail/client.hpp"
 
+#include <cstdlib>
+#include <future>
+#include <map>
+#include <new>
+#include <thread>
+
 #include "catch2/catch.hpp"
+#include "nlohmann/json.hpp"
 #include "tests/devkit/tmpfile.hpp"
 #include "touca/devkit/resultfile.hpp"
 #include "touca/devkit/utils.hpp"
+#include "touca/touca.hpp"
 
 using namespace touca;
 
+struct Counted {
+  static unsigned serializations;
+  int value;
+};
+
+unsigned Counted::serializations = 0u;
+
+template <>
+struct touca::serializer<Counted> {
+  data_point serialize(const Counted& counted) {
+    ++Counted::serializations;
+    return data_point::number_signed(counted.value);
+  }
+};
+
 std::string save_and_read_back(const touca::ClientImpl& client) {
   TmpFile file;
   CHECK_NOTHROW(client.save(file.path, {}, DataFormat::JSON, true));
@@ -26,6 +49,7 @@ TEST_CASE("empty client") {
   touca::ClientImpl client;
   REQUIRE(client.is_configured() == false);
   CHECK(client.configuration_error().empty() == true);
+  CHECK(client.has_last_testcase() == false);
   REQUIRE_NOTHROW(client.configure({{"api-key", "some-secret-key"},
                                     {"api-url", "http://localhost:8081"},
                                     {"team", "myteam"},
@@ -76,8 +100,10 @@ TEST_CASE("using a configured client") {
   CHECK(client.configuration_error().empty() == true);
 
   SECTION("testcase switch") {
+    CHECK(client.has_last_testcase() == false);
     CHECK_NOTHROW(client.add_hit_count("ignored-key"));
     CHECK(client.declare_testcase("some-case"));
+    CHECK(client.has_last_testcase() == true);
     CHECK_NOTHROW(client.add_hit_count("some-key"));
     CHECK(client.declare_testcase("some-other-case"));
     CHECK_NOTHROW(client.add_hit_count("some-other-key"));
@@ -131,6 +157,35 @@ TEST_CASE("using a configured client") {
     CHECK_THAT(content, Catch::Contains(expected));
   }
 
+  SECTION("testcase handle") {
+    client.declare_testcase("some-case");
+    touca::testcase_handle handle(client.find_testcase("some-case"));
+    client.declare_testcase("some-other-case");
+    REQUIRE(handle);
+    handle.check("some-value", true);
+    handle.add_array_element("some-array-value", "a");
+    handle.add_hit_count("some-other-value");
+    const auto& content = save_and_read_back(client);
+    const auto& expected =
+        R"("results":[{"key":"some-array-value","value":"[\"a\"]"},{"key":"some-other-value","value":"1"},{"key":"some-value","value":"true"}])";
+    CHECK_THAT(content, Catch::Contains(expected));
+    CHECK_FALSE(touca::testcase_handle());
+  }
+
+  SECTION("add_results") {
+    client.declare_testcase("some-case");
+    detail::result_list checks;
+    checks.emplace_back("some-value", data_point::boolean(true));
+    checks.emplace_back("some-other-value", data_point::number_unsigned(1u));
+    detail::result_list assumptions;
+    assumptions.emplace_back("some-assumption", data_point::boolean(false));
+    client.add_results(std::move(checks), std::move(assumptions));
+    const auto& content = save_and_read_back(client);
+    const auto& expected =
+        R"("results":[{"key":"some-other-value","value":"1"},{"key":"some-value","value":"true"}],"assertion":[{"key":"some-assumption","value":"false"}])";
+    CHECK_THAT(content, Catch::Contains(expected));
+  }
+
   SECTION("forget_testcase") {
     client.declare_testcase("some-case");
     const auto& v1 = data_point::boolean(true);
@@ -139,10 +194,27 @@ TEST_CASE("using a configured client") {
     client.start_timer("some-metric");
     client.stop_timer("some-metric");
     client.forget_testcase("some-case");
+    CHECK(client.has_last_testcase() == false);
+    CHECK_NOTHROW(client.check("some-value", v1));
     const auto& content = save_and_read_back(client);
     CHECK_THAT(content, Catch::Contains(R"([])"));
   }
 
+  SECTION("forgotten testcase is released") {
+    client.declare_testcase("some-case");
+    client.declare_testcase("some-other-case");
+    const std::weak_ptr<detail::testcase_entry> entry =
+        client.find_testcase("some-case");
+    auto previous = client.enter_context(entry.lock());
+    client.check("some-value", data_point::boolean(true));
+    client.forget_testcase("some-case");
+    CHECK(client.has_last_testcase() == false);
+    CHECK(entry.expired());
+    client.leave_context(std::move(previous));
+    CHECK(client.current_testcase() ==
+          client.find_testcase("some-other-case"));
+  }
+
   /**
    * Calling post when client is locally configured should throw exception.
    */
@@ -152,3 +224,402 @@ TEST_CASE("using a configured client") {
     REQUIRE(client.post() == false);
   }
 }
+
+TEST_CASE("concurrent capture") {
+  constexpr auto thread_count = 8u;
+  constexpr auto iterations = 1000u;
+  touca::ClientImpl client;
+
+  SECTION("shared testcase") {
+    client.configure({{"team", "myteam"},
+                      {"suite", "mysuite"},
+                      {"version", "myversion"},
+                      {"offline", "true"}});
+    client.declare_testcase("some-case");
+    std::vector<std::thread> threads;
+    for (auto i = 0u; i < thread_count; ++i) {
+      threads.emplace_back([&client, i]() {
+        for (auto j = 0u; j < iterations; ++j) {
+          client.add_hit_count("hits");
+          client.add_array_element("elements", data_point::number_unsigned(i));
+        }
+        client.check("value", data_point::boolean(true));
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    const auto& tc = client.find_testcase("some-case");
+    REQUIRE(tc);
+    const auto& content = save_and_read_back(client);
+    CHECK_THAT(content, Catch::Contains(R"({"key":"hits","value":"8000"})"));
+    CHECK_THAT(content, Catch::Contains(R"({"key":"value","value":"true"})"));
+    tc->apply([](Testcase& testcase) {
+      CHECK(testcase.overview().keysCount == 3);
+    });
+  }
+
+  SECTION("hit counters") {
+    client.configure({{"team", "myteam"},
+                      {"suite", "mysuite"},
+                      {"version", "myversion"},
+                      {"offline", "true"}});
+    client.declare_testcase("some-case");
+    touca::testcase_handle handle(client.find_testcase("some-case"));
+    auto counter = handle.make_counter("hits");
+    REQUIRE(counter);
+    client.add_hit_count("hits");
+    std::vector<std::thread> threads;
+    for (auto i = 0u; i < thread_count; ++i) {
+      threads.emplace_back([&counter]() {
+        for (auto j = 0u; j < iterations; ++j) {
+          counter.increment();
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    CHECK_THAT(save_and_read_back(client),
+               Catch::Contains(R"({"key":"hits","value":"8001"})"));
+    handle.make_counter("hits").increment(2u);
+    CHECK_THAT(save_and_read_back(client),
+               Catch::Contains(R"({"key":"hits","value":"8003"})"));
+    CHECK_FALSE(touca::hit_counter());
+  }
+
+  SECTION("testcase per thread") {
+    client.configure({{"team", "myteam"},
+                      {"suite", "mysuite"},
+                      {"version", "myversion"},
+                      {"offline", "true"},
+                      {"single-thread", "true"}});
+    std::vector<std::thread> threads;
+    for (auto i = 0u; i < thread_count; ++i) {
+      threads.emplace_back([&client, i]() {
+        client.declare_testcase("case-" + std::to_string(i));
+        for (auto j = 0u; j < iterations; ++j) {
+          client.add_hit_count("hits");
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    const auto& content = save_and_read_back(client);
+    for (auto i = 0u; i < thread_count; ++i) {
+      CHECK_THAT(content, Catch::Contains("\"testcase\":\"case-" +
+                                          std::to_string(i) + "\""));
+    }
+    CHECK_THAT(content, Catch::Contains(R"({"key":"hits","value":"1000"})"));
+    CHECK_THAT(content, !Catch::Contains(R"({"key":"hits","value":"2000"})"));
+  }
+}
+
+TEST_CASE("testcase context") {
+  touca::ClientImpl client;
+  client.configure({{"team", "myteam"},
+                    {"suite", "mysuite"},
+                    {"version", "myversion"},
+                    {"offline", "true"}});
+  client.declare_testcase("case-a");
+  const auto& context = client.current_testcase();
+  REQUIRE(context);
+  client.declare_testcase("case-b");
+
+  SECTION("task on another thread") {
+    std::thread thread([&client, &context]() {
+      auto previous = client.enter_context(context);
+      client.add_hit_count("hits");
+      client.leave_context(std::move(previous));
+      CHECK(client.current_testcase() == client.find_testcase("case-b"));
+    });
+    thread.join();
+    const auto& content = save_and_read_back(client);
+    CHECK_THAT(content, Catch::Contains(R"({"key":"hits","value":"1"})"));
+    client.find_testcase("case-b")->apply([](Testcase& testcase) {
+      CHECK(testcase.overview().keysCount == 0);
+    });
+  }
+
+  SECTION("nested scopes") {
+    auto outer = client.enter_context(context);
+    auto inner = client.enter_context(nullptr);
+    CHECK(client.has_last_testcase() == false);
+    client.declare_testcase("case-c");
+    CHECK(client.current_testcase() == client.find_testcase("case-c"));
+    client.leave_context(std::move(inner));
+    CHECK(client.current_testcase() == context);
+    client.leave_context(std::move(outer));
+    CHECK(client.current_testcase() == client.find_testcase("case-c"));
+  }
+}
+
+TEST_CASE("testcase context propagation") {
+  touca::configure({{"team", "myteam"},
+                    {"suite", "mysuite"},
+                    {"version", "myversion"},
+                    {"offline", "true"}});
+  const auto& read_back = [](const std::string& testcase) -> std::string {
+    TmpFile file;
+    CHECK_NOTHROW(touca::save_json(file.path.string(), {testcase}));
+    return detail::load_string_file(file.path.string());
+  };
+  touca::declare_testcase("case-a");
+  const auto& context = touca::testcase_context::current();
+  REQUIRE(context);
+
+  SECTION("context scope") {
+    touca::declare_testcase("case-b");
+    std::thread thread([&context]() {
+      {
+        touca::context_scope scope(context);
+        touca::check("inside", true);
+      }
+      touca::check("outside", true);
+    });
+    thread.join();
+    CHECK_THAT(read_back("case-a"), Catch::Contains(R"("key":"inside")"));
+    CHECK_THAT(read_back("case-a"), !Catch::Contains(R"("key":"outside")"));
+    CHECK_THAT(read_back("case-b"), Catch::Contains(R"("key":"outside")"));
+    CHECK_THAT(read_back("case-b"), !Catch::Contains(R"("key":"inside")"));
+  }
+
+  SECTION("bind context") {
+    auto task = touca::bind_context([](const int value) {
+      touca::check("value", value);
+      touca::add_array_element("elements", value);
+    });
+    touca::declare_testcase("case-b");
+    std::thread first(task, 1);
+    first.join();
+    CHECK_THAT(read_back("case-a"),
+               Catch::Contains(R"({"key":"value","value":"1"})"));
+    touca::declare_testcase("case-c");
+    std::thread second(task, 2);
+    second.join();
+    CHECK_THAT(read_back("case-a"),
+               Catch::Contains(R"({"key":"elements","value":"[1,2]"})"));
+    CHECK_THAT(read_back("case-b"), !Catch::Contains(R"("key":"value")"));
+    CHECK_THAT(read_back("case-c"), !Catch::Contains(R"("key":"value")"));
+    touca::forget_testcase("case-c");
+  }
+
+  SECTION("async") {
+    std::promise<void> declared;
+    auto ready = declared.get_future().share();
+    auto result = touca::async(std::launch::async, [ready]() -> bool {
+      ready.wait();
+      touca::check("value", 42);
+      return static_cast<bool>(touca::testcase_context::current());
+    });
+    touca::declare_testcase("case-b");
+    declared.set_value();
+    CHECK(result.get());
+    CHECK_THAT(read_back("case-a"),
+               Catch::Contains(R"({"key":"value","value":"42"})"));
+    CHECK_THAT(read_back("case-b"), !Catch::Contains(R"("key":"value")"));
+  }
+
+  touca::forget_testcase("case-a");
+  touca::forget_testcase("case-b");
+}
+
+TEST_CASE("serialization of captured values") {
+  touca::configure({{"team", "myteam"},
+                    {"suite", "mysuite"},
+                    {"version", "myversion"},
+                    {"offline", "true"}});
+  Counted::serializations = 0u;
+  const Counted counted{42};
+
+  SECTION("skipped while no testcase is declared") {
+    touca::check("some-key", counted);
+    touca::assume("some-assumption", counted);
+    touca::add_array_element("elements", counted);
+    CHECK(Counted::serializations == 0u);
+  }
+
+  SECTION("performed once a testcase is declared") {
+    touca::declare_testcase("some-case");
+    touca::check("some-key", counted);
+    touca::assume("some-assumption", counted);
+    touca::add_array_element("elements", counted);
+    CHECK(Counted::serializations == 3u);
+    touca::forget_testcase("some-case");
+    touca::check("some-key", counted);
+    CHECK(Counted::serializations == 3u);
+  }
+}
+
+TEST_CASE("array appenders") {
+  constexpr auto count = 5000u;
+  touca::ClientImpl client;
+  client.configure({{"team", "myteam"},
+                    {"suite", "mysuite"},
+                    {"version", "myversion"},
+                    {"offline", "true"}});
+  client.declare_testcase("some-case");
+  touca::testcase_handle handle(client.find_testcase("some-case"));
+
+  SECTION("elements of any type") {
+    client.add_array_element("values", data_point::boolean(true));
+    auto appender = handle.make_appender("values");
+    REQUIRE(appender);
+    for (auto i = 0u; i < count; ++i) {
+      appender.add(i);
+    }
+    appender.add("last");
+    const auto& content = save_and_read_back(client);
+    CHECK_THAT(content, Catch::Contains(R"("value":"[true,0,1,2,)"));
+    CHECK_THAT(content, Catch::Contains(R"(,4999,\"last\"]")"));
+  }
+
+  SECTION("packed numbers") {
+    auto appender = handle.make_packed_appender<std::uint64_t>("values");
+    for (auto i = 0u; i < count; ++i) {
+      appender.add(i);
+    }
+    CHECK_THAT(save_and_read_back(client),
+               Catch::Contains(R"("value":"[0,1,2,)"));
+    appender.add(count);
+    const auto& content = save_and_read_back(client);
+    CHECK_THAT(content, Catch::Contains(R"(,4999,5000]")"));
+    client.find_testcase("some-case")->apply([](Testcase& testcase) {
+      CHECK(testcase.overview().keysCount == 1);
+    });
+  }
+
+  SECTION("conflicting type") {
+    client.check("values", data_point::boolean(true));
+    handle.make_appender("values").add(1);
+    CHECK_THAT(save_and_read_back(client),
+               Catch::Contains(R"({"key":"values","value":"true"})"));
+    CHECK_FALSE(touca::array_appender());
+  }
+}
+
+#ifndef _WIN32
+// counts heap allocations made by the calling thread while enabled, to
+// check that capturing values into an arena does not allocate per node.
+static thread_local bool count_allocations = false;
+static thread_local std::size_t allocation_count = 0u;
+static thread_local std::size_t allocation_bytes = 0u;
+
+void* operator new(std::size_t size) {
+  if (count_allocations) {
+    ++allocation_count;
+    allocation_bytes += size;
+  }
+  if (const auto ptr = std::malloc(size ? size : 1u)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  if (count_allocations) {
+    ++allocation_count;
+    allocation_bytes += size;
+  }
+  return std::malloc(size ? size : 1u);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+TEST_CASE("capture with arena") {
+  std::map<std::string, int> values;
+  for (auto i = 0; i < 100; ++i) {
+    values.emplace("key-" + std::to_string(i), i);
+  }
+  const auto& capture = [&values](const std::string& arena) {
+    touca::ClientImpl client;
+    client.configure({{"team", "myteam"},
+                      {"suite", "mysuite"},
+                      {"version", "myversion"},
+                      {"offline", "true"},
+                      {"arena", arena}});
+    client.declare_testcase("some-case");
+    touca::testcase_handle handle(client.find_testcase("some-case"));
+    // creates the capture buffer of this thread and the first block of
+    // its arena, if any.
+    handle.add_array_element("elements", 0);
+    CHECK_THAT(save_and_read_back(client),
+               Catch::Contains(R"("value":"[0]")"));
+    allocation_count = 0u;
+    count_allocations = true;
+    handle.check("values", values);
+    count_allocations = false;
+    std::thread thread([&client]() {
+      client.declare_testcase("some-case");
+      client.add_array_element("elements", data_point::number_signed(1));
+    });
+    thread.join();
+    CHECK_THAT(save_and_read_back(client),
+               Catch::Contains(R"("value":"[0,1]")"));
+    handle.add_array_element("elements", 2);
+    const auto& content = save_and_read_back(client);
+    CHECK_THAT(content, Catch::Contains(R"("value":"[0,1,2]")"));
+    CHECK_THAT(content, Catch::Contains(R"(\"key-99\",\"second\":99)"));
+    client.forget_testcase("some-case");
+    return allocation_count;
+  };
+
+  // nodes of the captured map are allocated from the arena. the few
+  // remaining allocations index the result in the capture buffer.
+  CHECK(capture("true") < 10u);
+  CHECK(capture("false") > 100u);
+}
+
+TEST_CASE("merge of array appenders") {
+  constexpr auto count = 16u * 4096u;
+  touca::ClientImpl client;
+  client.configure({{"team", "myteam"},
+                    {"suite", "mysuite"},
+                    {"version", "myversion"},
+                    {"offline", "true"}});
+  client.declare_testcase("some-case");
+  const auto& entry = client.find_testcase("some-case");
+  touca::testcase_handle handle(entry);
+  auto appender = handle.make_packed_appender<std::uint64_t>("values");
+  for (auto i = 0u; i < count; ++i) {
+    appender.add(i);
+  }
+  allocation_bytes = 0u;
+  count_allocations = true;
+  CHECK(entry->flush().empty());
+  count_allocations = false;
+
+  // the merged result is allocated once to hold the elements of all
+  // chunks, rather than grown as each chunk is appended.
+  CHECK(allocation_bytes < count * sizeof(std::uint64_t) * 3u / 2u);
+  CHECK_THAT(save_and_read_back(client), Catch::Contains(R"(,65535]")"));
+  client.forget_testcase("some-case");
+}
+
+TEST_CASE("first capture of a key") {
+  touca::Testcase testcase("myteam", "mysuite", "myversion", "some-case");
+  // long enough for the name of the key to be allocated on the heap
+  const std::string name = "some-key-whose-name-is-long";
+  allocation_count = 0u;
+  count_allocations = true;
+  testcase.check(touca::key(name), data_point::number_signed(1));
+  count_allocations = false;
+  // one for the name of the key and one for the entry of its result
+  CHECK(allocation_count == 2u);
+  testcase.check(touca::key(name), data_point::number_signed(2));
+  testcase.add_array_element(touca::key("elements"),
+                             data_point::number_signed(1));
+  testcase.add_array_element(touca::key("elements"),
+                             data_point::number_signed(2));
+  CHECK(testcase.overview().keysCount == 2);
+  CHECK_THAT(testcase.json().dump(), Catch::Contains(R"("value":"1")"));
+  CHECK_THAT(testcase.json().dump(), Catch::Contains(R"("value":"[1,2]")"));
+}
+#endif
@@ -0,0 +1,49 @@
+// Copyright 2021 Touca, Inc. Subject to Apache-2.0 License.
+
+// This file is compiled with `TOUCA_DISABLE_CAPTURE` defined, to verify
+// that data capturing functions compile for types with no serializer
+// and capture nothing.
+
+#ifndef TOUCA_DISABLE_CAPTURE
+#error "this file is expected to be compiled with TOUCA_DISABLE_CAPTURE"
+#endif
+
+#include <map>
+#include <string>
+
+#include "catch2/catch.hpp"
+#include "tests/devkit/tmpfile.hpp"
+#include "touca/devkit/utils.hpp"
+#include "touca/touca.hpp"
+
+namespace {
+
+// intentionally has no specialization of `touca::serializer`
+struct Opaque {
+  int value;
+};
+
+}  // namespace
+
+TEST_CASE("capture when disabled") {
+  touca::configure({{"team", "myteam"},
+                    {"suite", "mysuite"},
+                    {"version", "myversion"},
+                    {"offline", "true"}});
+  touca::declare_testcase("disabled-case");
+  const Opaque opaque{42};
+  touca::check("some-key", opaque);
+  touca::assume("some-assumption", opaque);
+  touca::add_array_element("elements", opaque);
+  touca::check_many(std::map<std::string, Opaque>{{"many-key", opaque}});
+
+  TmpFile file;
+  CHECK_NOTHROW(touca::save_json(file.path.string(), {"disabled-case"}));
+  const auto& content = touca::detail::load_string_file(file.path.string());
+  CHECK_THAT(content, Catch::Contains("disabled-case"));
+  CHECK_THAT(content, !Catch::Contains("some-key"));
+  CHECK_THAT(content, !Catch::Contains("some-assumption"));
+  CHECK_THAT(content, !Catch::Contains("elements"));
+  CHECK_THAT(content, !Catch::Contains("many-key"));
+  touca::forget_testcase("disabled-case");
+}
@@ -0,0 +1,649 @@
+// Copyright 2021 Touca, Inc. Subject to Apache-2.0 License.
+
+#include "touca/client/detail/submission.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "httplib.h"
+#include "tests/devkit/tmpfile.hpp"
+#include "touca/client/detail/client.hpp"
+#include "touca/devkit/platform.hpp"
+#include "touca/extra/logger.hpp"
+
+using namespace touca;
+
+TEST_CASE("submission queue") {
+  SECTION("performs submissions in order") {
+    std::vector<unsigned> performed;
+    {
+      detail::submission_queue queue(2u);
+      for (auto i = 0u; i < 10u; ++i) {
+        queue.push([&performed, i]() -> bool {
+          performed.push_back(i);
+          return true;
+        });
+      }
+      CHECK(queue.wait());
+      CHECK(performed.size() == 10u);
+      queue.push([&performed]() -> bool {
+        performed.push_back(10u);
+        return true;
+      });
+    }
+    REQUIRE(performed.size() == 11u);
+    for (auto i = 0u; i < performed.size(); ++i) {
+      CHECK(performed.at(i) == i);
+    }
+  }
+
+  SECTION("performs failed submissions again") {
+    detail::submission_queue queue(4u);
+    unsigned attempts = 0u;
+    queue.push([&attempts]() { return 2u < ++attempts; });
+    queue.push([]() { return true; });
+    CHECK_FALSE(queue.wait());
+    CHECK(attempts == 2u);
+    CHECK(queue.wait());
+    CHECK(attempts == 3u);
+    CHECK(queue.wait());
+    CHECK(attempts == 3u);
+  }
+
+  SECTION("keeps submissions that throw") {
+    detail::submission_queue queue(4u);
+    unsigned attempts = 0u;
+    queue.push([&attempts]() -> bool {
+      ++attempts;
+      throw std::runtime_error("some error");
+    });
+    CHECK_FALSE(queue.wait());
+    CHECK_FALSE(queue.wait());
+    CHECK(attempts == 3u);
+  }
+
+  SECTION("blocks while full") {
+    std::promise<void> gate;
+    const auto released = gate.get_future().share();
+    std::atomic<unsigned> performed(0u);
+    detail::submission_queue queue(1u);
+    const auto job = [released, &performed]() -> bool {
+      released.wait();
+      ++performed;
+      return true;
+    };
+    queue.push(job);
+    std::atomic<bool> pushed(false);
+    std::thread producer([&queue, &pushed, &job]() {
+      queue.push(job);
+      queue.push(job);
+      pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_FALSE(pushed);
+    gate.set_value();
+    producer.join();
+    CHECK(queue.wait());
+    CHECK(performed == 3u);
+  }
+}
+
+TEST_CASE("split by size") {
+  using groups = std::vector<std::size_t>;
+  CHECK(detail::split_by_size({}, 10u).empty());
+  CHECK(detail::split_by_size({4u, 4u, 2u, 1u}, 10u) == groups{0u, 3u});
+  CHECK(detail::split_by_size({4u, 20u, 4u, 4u}, 10u) == groups{0u, 1u, 2u});
+  CHECK(detail::split_by_size({20u, 20u}, 10u) == groups{0u, 1u});
+  CHECK(detail::split_by_size({1u, 1u, 1u}, 0u) == groups{0u, 1u, 2u});
+}
+
+/**
+ * Stand-in for the Touca server that accepts test results submitted by
+ * the client once `release` is called.
+ */
+struct local_server {
+  local_server() : released(gate.get_future().share()) {
+    server.Get("/client/element/myteam/mysuite",
+               [this](const httplib::Request&, httplib::Response& res) {
+                 ++listings;
+                 res.status = 200;
+                 res.set_content(R"([{"name":"case-0"}])", "application/json");
+               });
+    server.Post("/client/signin",
+                [this](const httplib::Request&, httplib::Response& res) {
+                  ++signins;
+                  if (!authorize) {
+                    res.status = 401;
+                    return;
+                  }
+                  res.status = 200;
+                  res.set_content(R"({"token":"some-token"})",
+                                  "application/json");
+                });
+    server.Get("/platform",
+               [this](const httplib::Request&, httplib::Response& res) {
+                 res.status = 200;
+                 if (gzip) {
+                   res.set_header("Accept-Encoding", "gzip");
+                 }
+                 res.set_content(R"({"ready":true})", "application/json");
+               });
+    server.Post("/client/submit",
+                [this](const httplib::Request& req, httplib::Response& res) {
+                  {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    encoding = req.get_header_value("Content-Encoding");
+                    content = req.body;
+                  }
+                  ++waiting;
+                  released.wait();
+                  if (0u < unauthorized) {
+                    --unauthorized;
+                    res.status = 401;
+                    return;
+                  }
+                  if (0u < rejections) {
+                    --rejections;
+                    std::lock_guard<std::mutex> lock(mutex);
+                    res.status = 503;
+                    res.set_header("Retry-After", retry_after);
+                    return;
+                  }
+                  res.status = accept ? 204 : 500;
+                  submissions += accept ? 1u : 0u;
+                });
+    server.Post("/batch/myteam/mysuite/myversion/seal2",
+                [this](const httplib::Request&, httplib::Response& res) {
+                  sealed_after = submissions.load();
+                  sealed = true;
+                  res.status = 204;
+                });
+    port = server.bind_to_any_port("127.0.0.1");
+    if (0 < port) {
+      listener = std::thread([this]() { server.listen_after_bind(); });
+    }
+  }
+
+  ~local_server() {
+    release();
+    server.stop();
+    if (listener.joinable()) {
+      listener.join();
+    }
+  }
+
+  void release() {
+    if (!is_released) {
+      is_released = true;
+      gate.set_value();
+    }
+  }
+
+  std::string api_url() const {
+    return "http://127.0.0.1:" + std::to_string(port) +
+           "/@/myteam/mysuite/myversion";
+  }
+
+  httplib::Server server;
+  std::promise<void> gate;
+  std::shared_future<void> released;
+  bool is_released = false;
+  std::atomic<bool> accept{true};
+  std::atomic<bool> authorize{true};
+  // whether the server accepts compressed submissions
+  std::atomic<bool> gzip{true};
+  std::atomic<unsigned> signins{0u};
+  std::atomic<unsigned> listings{0u};
+  // number of upcoming submissions to reject as temporarily unavailable
+  std::atomic<unsigned> rejections{0u};
+  // number of upcoming submissions to reject as not authenticated
+  std::atomic<unsigned> unauthorized{0u};
+  std::atomic<unsigned> waiting{0u};
+  std::mutex mutex;
+  std::string retry_after = "0";
+  // content coding and content of the most recent submission
+  std::string encoding;
+  std::string content;
+  std::atomic<unsigned> submissions{0u};
+  std::atomic<unsigned> sealed_after{0u};
+  std::atomic<bool> sealed{false};
+  int port = -1;
+  std::thread listener;
+};
+
+TEST_CASE("asynchronous post") {
+  local_server server;
+  if (server.port <= 0) {
+    WARN("skipped since local server could not bind to a port");
+    return;
+  }
+  ClientImpl client;
+  REQUIRE(client.configure({{"api-key", "some-key"},
+                            {"api-url", server.api_url()},
+                            {"async-post", "true"}}));
+  REQUIRE(client.is_configured());
+
+  SECTION("post does not wait for submission") {
+    for (auto i = 0u; i < 3u; ++i) {
+      const auto name = "case-" + std::to_string(i);
+      client.declare_testcase(name);
+      client.check("some-key", data_point::number_unsigned(i));
+      CHECK(client.post());
+      client.forget_testcase(name);
+    }
+    CHECK(server.submissions == 0u);
+    server.release();
+    CHECK(client.seal());
+    CHECK(server.sealed);
+    CHECK(server.sealed_after == 3u);
+    // testcases are submitted with the results they had when posted,
+    // even though they are forgotten before they are submitted.
+    std::lock_guard<std::mutex> lock(server.mutex);
+    CHECK_THAT(server.content, Catch::Contains("case-2"));
+    CHECK_THAT(server.content, Catch::Contains("some-key"));
+  }
+
+  SECTION("failed submissions are reported and retried") {
+    server.accept = false;
+    server.release();
+    client.declare_testcase("some-case");
+    client.check("some-key", data_point::boolean(true));
+    CHECK(client.post());
+    CHECK_FALSE(client.flush());
+    CHECK(server.submissions == 0u);
+    server.accept = true;
+    CHECK(client.post());
+    CHECK(client.seal());
+    CHECK(server.sealed_after == 1u);
+  }
+
+  SECTION("failed submissions of forgotten testcases are retried") {
+    server.accept = false;
+    server.release();
+    client.declare_testcase("some-case");
+    client.check("some-key", data_point::boolean(true));
+    CHECK(client.post());
+    client.forget_testcase("some-case");
+    CHECK_FALSE(client.flush());
+    CHECK(server.submissions == 0u);
+    server.accept = true;
+    CHECK(client.flush());
+    CHECK(server.submissions == 1u);
+    CHECK_THAT(server.content, Catch::Contains("some-case"));
+    CHECK_THAT(server.content, Catch::Contains("some-key"));
+  }
+}
+
+struct recording_logger : public touca::logger {
+  void log(const Level level, const std::string msg) const override {
+    std::lock_guard<std::mutex> lock(mutex);
+    messages.emplace_back(level, msg);
+  }
+
+  std::size_t count(const Level level) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::count_if(
+        messages.begin(), messages.end(),
+        [level](const std::pair<Level, std::string>& message) {
+          return message.first == level;
+        });
+  }
+
+  mutable std::mutex mutex;
+  mutable std::vector<std::pair<Level, std::string>> messages;
+};
+
+TEST_CASE("authentication") {
+  local_server server;
+  if (server.port <= 0) {
+    WARN("skipped since local server could not bind to a port");
+    return;
+  }
+  server.release();
+  ClientOptions options;
+  options.api_key = "some-key";
+  options.api_url = server.api_url();
+  ClientImpl client;
+
+  SECTION("list of testcases is retrieved during configuration") {
+    REQUIRE(client.configure(options));
+    CHECK(client.get_testcases() == std::vector<std::string>{"case-0"});
+    client.declare_testcase("case-0");
+    CHECK(client.post());
+    CHECK(server.signins == 1u);
+    CHECK(server.listings == 1u);
+  }
+
+  SECTION("known testcases are run while authenticating") {
+    options.testcases = {"case-1"};
+    REQUIRE(client.configure(options));
+    client.declare_testcase("case-1");
+    CHECK(client.post());
+    CHECK(server.signins == 1u);
+    CHECK(server.listings == 0u);
+  }
+
+  SECTION("serialized testcases are released once posted") {
+    REQUIRE(client.configure(options));
+    client.declare_testcase("case-0");
+    client.check("some-key", data_point::boolean(true));
+    const auto& entry = client.find_testcase("case-0");
+    entry->flush();
+    const auto& testcase = entry->testcase();
+    std::weak_ptr<const std::vector<uint8_t>> message = testcase->message();
+    CHECK_FALSE(message.expired());
+    server.accept = false;
+    CHECK_FALSE(client.post());
+    CHECK_FALSE(message.expired());
+    server.accept = true;
+    CHECK(client.post());
+    CHECK(message.expired());
+  }
+
+  SECTION("failed authentication is reported on post") {
+    server.authorize = false;
+    options.testcases = {"case-1"};
+    REQUIRE(client.configure(options));
+    client.declare_testcase("case-1");
+    CHECK_FALSE(client.post());
+    CHECK_FALSE(client.seal());
+    CHECK(server.submissions == 0u);
+  }
+
+  SECTION("loggers are added while authenticating") {
+    server.gzip = false;
+    options.testcases = {"case-1"};
+    options.compression_level = 6u;
+    const auto logger = std::make_shared<recording_logger>();
+    client.add_logger(logger);
+    REQUIRE(client.configure(options));
+    client.add_logger(std::make_shared<recording_logger>());
+    client.declare_testcase("case-1");
+    CHECK(client.post());
+    CHECK(logger->count(touca::logger::Level::Warning) == 1u);
+    CHECK(server.submissions == 1u);
+  }
+
+  SECTION("failed authentication is reported on configure") {
+    server.authorize = false;
+    CHECK_FALSE(client.configure(options));
+    CHECK_FALSE(client.configuration_error().empty());
+  }
+}
+
+TEST_CASE("cached authentication") {
+  local_server server;
+  if (server.port <= 0) {
+    WARN("skipped since local server could not bind to a port");
+    return;
+  }
+  server.release();
+  TmpFile cache;
+  const auto& dir = cache.path.string();
+  Platform cold(ApiUrl(server.api_url()));
+  cold.set_cache(dir, std::chrono::seconds(60));
+  REQUIRE(cold.auth("some-key"));
+  REQUIRE(cold.elements() == std::vector<std::string>{"case-0"});
+  REQUIRE(server.signins == 1u);
+  REQUIRE(server.listings == 1u);
+  Platform warm(ApiUrl(server.api_url()));
+
+  SECTION("warm starts use cached token and testcases") {
+    warm.set_cache(dir, std::chrono::seconds(60));
+    CHECK(warm.auth("some-key"));
+    CHECK(warm.elements() == std::vector<std::string>{"case-0"});
+    CHECK(server.signins == 1u);
+    CHECK(server.listings == 1u);
+  }
+
+  SECTION("cached token is not used for a different key") {
+    warm.set_cache(dir, std::chrono::seconds(60));
+    CHECK(warm.auth("other-key"));
+    CHECK(server.signins == 2u);
+  }
+
+  SECTION("expired data is requested again") {
+    warm.set_cache(dir, std::chrono::seconds(0));
+    CHECK(warm.auth("some-key"));
+    CHECK(warm.elements() == std::vector<std::string>{"case-0"});
+    CHECK(server.signins == 2u);
+    CHECK(server.listings == 2u);
+  }
+
+  SECTION("rejected cached token is renewed") {
+    warm.set_cache(dir, std::chrono::seconds(60));
+    REQUIRE(warm.auth("some-key"));
+    server.unauthorized = 1u;
+    CHECK(warm.submit("some-content", 1u).empty());
+    CHECK(server.signins == 2u);
+    CHECK(server.submissions == 1u);
+  }
+}
+
+TEST_CASE("concurrently cached data") {
+  local_server server;
+  if (server.port <= 0) {
+    WARN("skipped since local server could not bind to a port");
+    return;
+  }
+  server.release();
+  TmpFile cache;
+  const auto& dir = cache.path.string();
+  for (auto i = 0u; i < 20u; ++i) {
+    // two processes starting at once cache different entries
+    Platform first(ApiUrl(server.api_url()));
+    Platform second(ApiUrl(server.api_url()));
+    first.set_cache(dir, std::chrono::seconds(60));
+    second.set_cache(dir, std::chrono::seconds(60));
+    std::thread thread([&first]() { CHECK(first.auth("some-key")); });
+    CHECK(second.elements() == std::vector<std::string>{"case-0"});
+    thread.join();
+
+    const auto signins = server.signins.load();
+    const auto listings = server.listings.load();
+    Platform warm(ApiUrl(server.api_url()));
+    warm.set_cache(dir, std::chrono::seconds(60));
+    CHECK(warm.auth("some-key"));
+    CHECK(warm.elements() == std::vector<std::string>{"case-0"});
+    CHECK(server.signins == signins);
+    CHECK(server.listings == listings);
+    touca::filesystem::remove_all(cache.path);
+  }
+}
+
+TEST_CASE("concurrent submissions") {
+  local_server server;
+  if (server.port <= 0) {
+    WARN("skipped since local server could not bind to a port");
+    return;
+  }
+  Platform platform(ApiUrl(server.api_url()));
+  REQUIRE(platform.auth("some-key"));
+  const std::string content = "some-content";
+  const auto data = reinterpret_cast<const uint8_t*>(content.data());
+  std::vector<std::future<std::vector<std::string>>> results;
+  for (auto i = 0u; i < 3u; ++i) {
+    results.push_back(platform.submit_async(data, content.size(), 1u));
+  }
+  // all submissions reach the server before any of them is answered
+  for (auto i = 0u; i < 100u && server.waiting < 3u; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  CHECK(server.waiting == 3u);
+  server.release();
+  for (auto& result : results) {
+    CHECK(result.get().empty());
+  }
+  CHECK(server.submissions == 3u);
+}
+
+TEST_CASE("retried submissions") {
+  local_server server;
+  if (server.port <= 0) {
+    WARN("skipped since local server could not bind to a port");
+    return;
+  }
+  server.release();
+  Platform platform(ApiUrl(server.api_url()));
+  REQUIRE(platform.auth("some-key"));
+  RetryPolicy policy;
+  policy.base_delay = std::chrono::milliseconds(1);
+  policy.max_delay = std::chrono::milliseconds(1500);
+  platform.set_retry_policy(policy);
+  const std::string content = "some-content";
+
+  SECTION("temporary failures are retried") {
+    server.rejections = 2u;
+    CHECK(platform.submit(content, 5u).empty());
+    const auto& stats = platform.submit_stats();
+    CHECK(stats.requests == 3u);
+    CHECK(stats.retries == 2u);
+    CHECK(stats.failures == 0u);
+    CHECK(server.submissions == 1u);
+  }
+
+  SECTION("retries wait as long as the server asks") {
+    server.rejections = 1u;
+    server.retry_after = "1";
+    const auto tic = std::chrono::steady_clock::now();
+    CHECK(platform.submit(content, 5u).empty());
+    CHECK(std::chrono::seconds(1) <= std::chrono::steady_clock::now() - tic);
+    CHECK(platform.submit_stats().retries == 1u);
+  }
+
+  SECTION("malformed retry delays are ignored") {
+    server.rejections = 1u;
+    server.retry_after = "\xb9\xb2";
+    CHECK(platform.submit(content, 5u).empty());
+    CHECK(platform.submit_stats().retries == 1u);
+    CHECK(server.submissions == 1u);
+  }
+
+  SECTION("retries that take too long are not attempted") {
+    server.rejections = 1u;
+    server.retry_after = "3600";
+    const auto& errors = platform.submit(content, 5u);
+    REQUIRE_FALSE(errors.empty());
+    CHECK(errors.back() == "giving up on submitting testresults");
+    const auto& stats = platform.submit_stats();
+    CHECK(stats.retries == 0u);
+    CHECK(stats.failures == 1u);
+  }
+
+  SECTION("retries of all submissions share a budget") {
+    policy.budget = 2u;
+    platform.set_retry_policy(policy);
+    server.accept = false;
+    CHECK_FALSE(platform.submit(content, 5u).empty());
+    CHECK_FALSE(platform.submit(content, 5u).empty());
+    const auto& stats = platform.submit_stats();
+    CHECK(stats.requests == 4u);
+    CHECK(stats.retries == 2u);
+    CHECK(stats.failures == 2u);
+  }
+}
+
+TEST_CASE("compressed submissions") {
+  local_server server;
+  if (server.port <= 0) {
+    WARN("skipped since local server could not bind to a port");
+    return;
+  }
+  server.release();
+  Platform platform(ApiUrl(server.api_url()));
+  REQUIRE(platform.auth("some-key"));
+  CHECK(platform.compress(6u).empty());
+  REQUIRE(platform.handshake());
+  if (platform.compress(6u).empty()) {
+    WARN("skipped since client is built without support for compression");
+    return;
+  }
+  const std::string content(4096u, 'a');
+  CHECK(platform.submit(content, 1u).empty());
+  {
+    std::lock_guard<std::mutex> lock(server.mutex);
+    CHECK(server.encoding == "gzip");
+    REQUIRE(server.content.size() > 2u);
+    CHECK(server.content.size() < content.size());
+    CHECK(static_cast<unsigned char>(server.content[0]) == 0x1fu);
+    CHECK(static_cast<unsigned char>(server.content[1]) == 0x8bu);
+  }
+  // retries send the content compressed for the first attempt
+  RetryPolicy policy;
+  policy.base_delay = std::chrono::milliseconds(1);
+  platform.set_retry_policy(policy);
+  server.rejections = 1u;
+  CHECK(platform.submit(content, 2u).empty());
+  CHECK(platform.submit_stats().retries == 1u);
+  {
+    std::lock_guard<std::mutex> lock(server.mutex);
+    CHECK(server.encoding == "gzip");
+    REQUIRE(server.content.size() > 2u);
+    CHECK(server.content.size() < content.size());
+    CHECK(static_cast<unsigned char>(server.content[0]) == 0x1fu);
+  }
+  CHECK(platform.compress(0u).empty());
+  CHECK(platform.submit(content, 1u).empty());
+  {
+    std::lock_guard<std::mutex> lock(server.mutex);
+    CHECK(server.encoding.empty());
+    CHECK(server.content == content);
+  }
+}
+
+TEST_CASE("batched post") {
+  local_server server;
+  if (server.port <= 0) {
+    WARN("skipped since local server could not bind to a port");
+    return;
+  }
+  server.release();
+  ClientImpl client;
+  REQUIRE(client.configure({{"api-key", "some-key"},
+                            {"api-url", server.api_url()},
+                            {"post-batch-bytes", "1"},
+                            {"post-concurrency", "4"}}));
+  REQUIRE(client.is_configured());
+
+  SECTION("testcases larger than the budget are submitted separately") {
+    for (auto i = 0u; i < 10u; ++i) {
+      client.declare_testcase("case-" + std::to_string(i));
+      client.check("some-key", data_point::number_unsigned(i));
+    }
+    CHECK(client.post());
+    CHECK(server.submissions == 10u);
+  }
+
+  SECTION("testcases within the budget share a request") {
+    REQUIRE(client.configure({{"post-batch-bytes", "1048576"}}));
+    for (auto i = 0u; i < 10u; ++i) {
+      client.declare_testcase("case-" + std::to_string(i));
+      client.check("some-key", data_point::number_unsigned(i));
+    }
+    CHECK(client.post());
+    CHECK(server.submissions == 1u);
+  }
+
+  SECTION("invalid options are reported") {
+    CHECK_FALSE(client.configure({{"post-concurrency", "many"}}));
+    CHECK_THAT(client.configuration_error(),
+               Catch::Contains("expected a number"));
+    CHECK_FALSE(client.configure({{"post-batch-bytes", "-1"}}));
+    CHECK_THAT(client.configuration_error(),
+               Catch::Contains("expected a number"));
+    CHECK_FALSE(client.configure({{"post-batch-bytes", "4294967296"}}));
+    CHECK_THAT(client.configuration_error(),
+               Catch::Contains("expected a number"));
+    CHECK_FALSE(client.configure({{"post-concurrency", "4abc"}}));
+    CHECK_THAT(client.configuration_error(),
+               Catch::Contains("expected a number"));
+  }
+}
@@ -4,6 +4,7 @@
 
 #include "catch2/catch.hpp"
 #include "nlohmann/json.hpp"
+#include "touca/core/serializer.hpp"
 #include "touca/devkit/comparison.hpp"
 
 using touca::data_point;
@@ -30,6 +31,44 @@ TEST_CASE("Testcase") {
     CHECK_NOTHROW(testcase.assume("some-key", value));
   }
 
+  SECTION("check: moved value") {
+    auto value = data_point(touca::array().add("a").add("b"));
+    testcase.check("some-key", std::move(value));
+    testcase.add_array_element("some-other-key", data_point::string("c"));
+    const auto expected =
+        R"("results":[{"key":"some-key","value":"[\"a\",\"b\"]"},{"key":"some-other-key","value":"[\"c\"]"}])";
+    REQUIRE_THAT(testcase.json().dump(), Catch::Contains(expected));
+  }
+
+  SECTION("add_results") {
+    testcase.check("some-key", data_point::boolean(true));
+    touca::detail::result_list results;
+    results.emplace_back("some-key", data_point::boolean(false));
+    results.emplace_back("some-other-key", data_point::number_unsigned(1u));
+    results.emplace_back("some-other-key", data_point::number_unsigned(2u));
+    testcase.add_results(std::move(results), touca::ResultCategory::Assert);
+    const auto expected =
+        R"("results":[{"key":"some-key","value":"true"}],"assertion":[{"key":"some-other-key","value":"1"}])";
+    REQUIRE_THAT(testcase.json().dump(), Catch::Contains(expected));
+  }
+
+  SECTION("keys") {
+    constexpr touca::key key("some-key");
+    static_assert(key.size() == 8u, "key is evaluated at compile time");
+    const std::string name = "some-key";
+    CHECK(touca::key(name).hash() == key.hash());
+    CHECK(touca::key(name.c_str()).hash() == key.hash());
+    CHECK(touca::key("some-other-key").hash() != key.hash());
+    testcase.add_hit_count(key);
+    testcase.add_hit_count(name);
+    testcase.add_hit_count("some-key");
+    const auto copy = testcase;
+    testcase.add_hit_count(key);
+    const auto expected = R"("results":[{"key":"some-key","value":"4"}])";
+    REQUIRE_THAT(testcase.json().dump(), Catch::Contains(expected));
+    REQUIRE_THAT(copy.json().dump(), Catch::Contains(R"("value":"3")"));
+  }
+
   SECTION("add_hit_count") {
     SECTION("expected-use") {
       testcase.add_hit_count("some-key");
@@ -113,6 +152,37 @@ TEST_CASE("Testcase") {
     CHECK_THAT(after, Catch::Contains(check4));
   }
 
+  /**
+   * The serialized form of a testcase is reused, by the testcase and its
+   * copies, until the testcase is changed.
+   */
+  SECTION("message") {
+    testcase.check("some-key", data_point::boolean(true));
+    const auto message = testcase.message();
+    CHECK(testcase.message() == message);
+    const auto copy = testcase;
+    CHECK(copy.message() == message);
+    testcase.add_hit_count("some-counter");
+    CHECK(testcase.message() != message);
+    CHECK(copy.message() == message);
+    const auto other = testcase.message();
+    testcase.add_array_element("some-array", data_point::boolean(true));
+    CHECK(testcase.message() != other);
+  }
+
+  SECTION("messages writer") {
+    testcase.check("some-key", data_point::boolean(true));
+    const auto expected = touca::Testcase::serialize({testcase});
+    touca::detail::messages_writer writer;
+    CHECK(writer.size() == 0u);
+    for (auto i = 0; i < 2; ++i) {
+      writer.write({testcase.message()});
+      const std::vector<uint8_t> output(writer.data(),
+                                        writer.data() + writer.size());
+      CHECK(output == expected);
+    }
+  }
+
   SECTION("overview") {
     const auto value = data_point::boolean(true);
     const auto check_counters =
@@ -245,3 +315,85 @@ TEST_CASE("Testcase") {
     CHECK_THAT(overview, Catch::Contains(check4));
   }
 }
+
+TEST_CASE("Testcase with arena") {
+  touca::Testcase testcase("some-team", "some-suite", "some-version",
+                           "some-case", true);
+  const auto& make_value = [](const int index) -> data_point {
+    return touca::object("some-type")
+        .add("index", index)
+        .add("name", "some-long-string-that-does-not-fit-in-sso")
+        .add("values", std::vector<double>{1.0, 2.0, 3.0});
+  };
+
+  SECTION("capture") {
+    for (auto i = 0; i < 100; ++i) {
+      testcase.check("key-" + std::to_string(i), make_value(i));
+      testcase.add_array_element("some-array", make_value(i));
+    }
+    touca::Testcase expected("some-team", "some-suite", "some-version",
+                             "some-case");
+    for (auto i = 0; i < 100; ++i) {
+      expected.check("key-" + std::to_string(i), make_value(i));
+      expected.add_array_element("some-array", make_value(i));
+    }
+    CHECK(testcase.json().at("results") == expected.json().at("results"));
+  }
+
+  SECTION("copy outlives clear") {
+    testcase.check("some-key", make_value(1));
+    const auto copy = testcase;
+    testcase.clear();
+    testcase.check("some-other-key", make_value(2));
+    const auto expected =
+        R"("results":[{"key":"some-key","value":"{\"some-type\":{\"index\":1,\"name\":\"some-long-string-that-does-not-fit-in-sso\",\"values\":[1.0,2.0,3.0]}}"}])";
+    CHECK_THAT(copy.json().dump(), Catch::Contains(expected));
+  }
+
+  SECTION("assignment") {
+    // array elements are allocated from the arena of their testcase
+    testcase.add_array_element("some-array", make_value(1));
+    touca::Testcase other("some-team", "some-suite", "some-version",
+                          "other-case", true);
+    other.add_array_element("other-array", make_value(2));
+    // results of the testcase are released before the arena they are
+    // allocated from, which is not shared with any copy.
+    testcase = other;
+    CHECK(testcase.json() == other.json());
+    touca::Testcase moved("some-team", "some-suite", "some-version",
+                          "moved-case", true);
+    moved.add_array_element("moved-array", make_value(3));
+    testcase = std::move(moved);
+    testcase.add_array_element("some-array", make_value(4));
+    const auto json = testcase.json();
+    const auto& results = json.at("results");
+    REQUIRE(results.size() == 2u);
+    CHECK(results.at(0).at("key") == "moved-array");
+    CHECK(results.at(1).at("key") == "some-array");
+  }
+
+  SECTION("arena") {
+    touca::detail::arena arena(64);
+    CHECK(arena.capacity() == 0u);
+    const auto first = arena.allocate(24, 8);
+    const auto second = arena.allocate(24, 8);
+    CHECK(first != second);
+    CHECK(reinterpret_cast<std::uintptr_t>(second) % 8 == 0u);
+    CHECK_NOTHROW(arena.allocate(1024, 16));
+    CHECK(arena.capacity() > 1024u);
+    arena.release();
+    CHECK(arena.capacity() == 0u);
+  }
+
+  SECTION("scope") {
+    touca::detail::arena arena;
+    CHECK(touca::detail::active_arena() == nullptr);
+    {
+      touca::detail::arena_scope scope(&arena);
+      CHECK(touca::detail::active_arena() == &arena);
+      const auto value = make_value(1);
+      CHECK(arena.capacity() != 0u);
+    }
+    CHECK(touca::detail::active_arena() == nullptr);
+  }
+}
@@ -2,6 +2,8 @@
 
 #include "touca/core/types.hpp"
 
+#include <limits>
+
 #include "catch2/catch.hpp"
 #include "touca/core/serializer.hpp"
 #include "touca/devkit/comparison.hpp"
@@ -9,6 +11,7 @@
 #include "touca/impl/schema.hpp"
 
 using touca::detail::internal_type;
+using touca::detail::unmatched_fingerprint;
 
 class Head {
   friend struct touca::serializer<Head>;
@@ -337,6 +340,67 @@ TEST_CASE("Simple Data Types") {
     }
   }
 
+  SECTION("fingerprint") {
+    SECTION("packed and unpacked arrays") {
+      auto packed =
+          serializer<std::vector<int>>().serialize(std::vector<int>{1, 2, 3});
+      const auto& unpacked = data_point(array().add(1).add(2).add(3));
+      CHECK(internal_type::packed_array == packed.type());
+      CHECK(packed.fingerprint() == unpacked.fingerprint());
+      packed.unpack();
+      CHECK(packed.fingerprint() == unpacked.fingerprint());
+    }
+
+    SECTION("distinct values") {
+      CHECK(data_point::number_signed(1).fingerprint() !=
+            data_point::number_unsigned(1).fingerprint());
+      CHECK(data_point::string("a").fingerprint() !=
+            data_point::string("b").fingerprint());
+      CHECK(data_point(array().add(1).add(2)).fingerprint() !=
+            data_point(array().add(2).add(1)).fingerprint());
+    }
+
+    SECTION("unmatched values") {
+      const auto nan = std::numeric_limits<double>::quiet_NaN();
+      CHECK(data_point::null().fingerprint() == unmatched_fingerprint);
+      CHECK(data_point::number_double(nan).fingerprint() ==
+            unmatched_fingerprint);
+      CHECK(data_point(array().add(1).add(nan)).fingerprint() ==
+            unmatched_fingerprint);
+    }
+
+    SECTION("modified array") {
+      const auto& value = data_point(array().add(1));
+      const auto before = value.fingerprint();
+      value.as_array()->push_back(data_point::number_signed(2));
+      CHECK(value.fingerprint() != before);
+      CHECK(value.fingerprint() ==
+            data_point(array().add(1).add(2)).fingerprint());
+    }
+
+    SECTION("modified nested value") {
+      const auto& make = []() -> data_point {
+        const data_point element = array().add(1);
+        const data_point member = object("some-type").add("a", 1);
+        return array().add(element).add(member);
+      };
+      const auto& src = make();
+      const auto& dst = make();
+      auto& elements = *dst.as_array();
+      CHECK(MatchType::Perfect == compare(src, dst).match);
+      elements.front().as_array()->push_back(data_point::number_signed(2));
+      const auto& cmp = compare(src, dst);
+      CHECK(MatchType::None == cmp.match);
+      CHECK(cmp.score < 1.0);
+      CHECK(src.fingerprint() != dst.fingerprint());
+      elements.front().as_array()->pop_back();
+      CHECK(MatchType::Perfect == compare(src, dst).match);
+      elements.back().as_object()->members.begin()->second =
+          data_point::number_signed(2);
+      CHECK(MatchType::None == compare(src, dst).match);
+    }
+  }
+
   SECTION("type: array") {
     SECTION("initialize") {
       const auto& value = data_point(array());
@@ -497,7 +561,7 @@ TEST_CASE("Simple Data Types") {
       CHECK(MatchType::None == cmp.match);
       CHECK(cmp.score == 0.95);
       CHECK(cmp.desc.size() == 1u);
-      CHECK(cmp.desc.count("[5]:value is larger by 14.000000"));
+      CHECK(cmp.desc.count("[14]:value is larger by 14.000000"));
     }
 
     SECTION("compare: mismatch size") {
@@ -562,6 +626,213 @@ TEST_CASE("Simple Data Types") {
     }
   }
 
+  SECTION("type: packed array") {
+    SECTION("initialize") {
+      const auto& value = serializer<std::vector<double>>().serialize(
+          std::vector<double>{1.0, 1.5, 2.0});
+      CHECK(internal_type::packed_array == value.type());
+      CHECK(value.as_packed_array()->size() == 3u);
+      CHECK(value.to_string() == "[1.0,1.5,2.0]");
+      CHECK(flatten(value).size() == 3ul);
+      CHECK(flatten(value).at("[1]").to_string() == "1.5");
+    }
+
+    SECTION("initialize: element types") {
+      const auto& signed_value =
+          serializer<std::vector<short>>().serialize({-1, 2});
+      const auto& unsigned_value =
+          serializer<std::set<unsigned>>().serialize({3u, 1u});
+      const auto& bool_value =
+          serializer<std::vector<bool>>().serialize({true, false});
+      CHECK(signed_value.as_packed_array()->element_type ==
+            internal_type::number_signed);
+      CHECK(signed_value.to_string() == "[-1,2]");
+      CHECK(unsigned_value.as_packed_array()->element_type ==
+            internal_type::number_unsigned);
+      CHECK(unsigned_value.to_string() == "[1,3]");
+      CHECK(internal_type::array == bool_value.type());
+    }
+
+    SECTION("unpack") {
+      auto value = serializer<std::vector<int>>().serialize({1, 2});
+      value.unpack();
+      CHECK(internal_type::array == value.type());
+      CHECK(value.as_array()->size() == 2u);
+      CHECK(value.to_string() == "[1,2]");
+    }
+
+    SECTION("compare: match") {
+      std::vector<double> elements(1000);
+      std::iota(elements.begin(), elements.end(), 0.5);
+      const auto& left = serializer<std::vector<double>>().serialize(elements);
+      const auto& right = serializer<std::vector<double>>().serialize(elements);
+      const auto& cmp = compare(left, right);
+
+      CHECK(internal_type::array == cmp.srcType);
+      CHECK(internal_type::unknown == cmp.dstType);
+      CHECK(cmp.dstValue == "");
+      CHECK(MatchType::Perfect == cmp.match);
+      CHECK(cmp.score == 1.0);
+      CHECK(cmp.desc.empty());
+    }
+
+    SECTION("compare: mismatch value") {
+      std::vector<int> elements(20);
+      std::iota(elements.begin(), elements.end(), 0);
+      const auto& left = serializer<std::vector<int>>().serialize(elements);
+      elements[14] = 0;
+      const auto& right = serializer<std::vector<int>>().serialize(elements);
+      const auto& cmp = compare(left, right);
+
+      CHECK(internal_type::array == cmp.srcType);
+      CHECK(MatchType::None == cmp.match);
+      CHECK(cmp.score == 0.95);
+      CHECK(cmp.desc.size() == 1u);
+      CHECK(cmp.desc.count("[14]:value is larger by 14.000000"));
+    }
+
+    SECTION("compare: mismatch value: large") {
+      std::vector<double> elements(1003);
+      std::iota(elements.begin(), elements.end(), 1.0);
+      const auto& left = serializer<std::vector<double>>().serialize(elements);
+      touca::array unpacked_left;
+      for (const auto& element : elements) {
+        unpacked_left.add(element);
+      }
+      elements[0] = 1.5;
+      elements[5] = 100.0;
+      elements[1002] = 1000.0;
+      const auto& right = serializer<std::vector<double>>().serialize(elements);
+      touca::array unpacked_right;
+      for (const auto& element : elements) {
+        unpacked_right.add(element);
+      }
+      const auto& cmp = compare(left, right);
+      const auto& expected = compare(unpacked_left, unpacked_right);
+
+      CHECK(MatchType::None == cmp.match);
+      CHECK(cmp.score == Approx(expected.score));
+      CHECK(cmp.desc.size() == 3u);
+      CHECK(cmp.desc.count("[0]:value is smaller by 0.500000"));
+      CHECK(cmp.desc.count("[5]:value is smaller by 94.000000"));
+      CHECK(cmp.desc.count("[1002]:value is larger by 0.300000 percent"));
+    }
+
+    SECTION("compare: special values") {
+      const auto nan = std::numeric_limits<float>::quiet_NaN();
+      const auto& left = serializer<std::vector<float>>().serialize(
+          {0.0f, 1.0f, nan, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f});
+      const auto& right = serializer<std::vector<float>>().serialize(
+          {-0.0f, 1.0f, nan, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f});
+      const auto& cmp = compare(left, right);
+
+      CHECK(MatchType::None == cmp.match);
+      CHECK(cmp.score == Approx(8.0 / 9.0));
+      CHECK(cmp.desc.size() == 1u);
+    }
+
+    SECTION("compare: mismatch size") {
+      const auto& left =
+          serializer<std::vector<int>>().serialize(std::vector<int>(4, 1));
+      const auto& right =
+          serializer<std::vector<int>>().serialize(std::vector<int>(6, 1));
+      const auto& cmp = compare(left, right);
+
+      CHECK(cmp.dstValue == "[1,1,1,1,1,1]");
+      CHECK(MatchType::None == cmp.match);
+      CHECK(cmp.score == 0.0);
+      CHECK(cmp.desc.size() == 1u);
+      CHECK(cmp.desc.count("array size shrunk by 2 elements"));
+    }
+
+    SECTION("compare: array") {
+      const auto& left = serializer<std::vector<int>>().serialize({1, 2, 3});
+      const data_point right = touca::array().add(1).add(2).add(3);
+      const auto& cmp = compare(left, right);
+
+      CHECK(internal_type::array == cmp.srcType);
+      CHECK(internal_type::unknown == cmp.dstType);
+      CHECK(MatchType::Perfect == cmp.match);
+      CHECK(cmp.score == 1.0);
+    }
+
+    SECTION("compare: mismatch element type") {
+      const auto& left = serializer<std::vector<int>>().serialize({1, 2});
+      const auto& right = serializer<std::vector<float>>().serialize({1, 2});
+      const auto& cmp = compare(left, right);
+
+      CHECK(internal_type::array == cmp.srcType);
+      CHECK(internal_type::unknown == cmp.dstType);
+      CHECK(MatchType::None == cmp.match);
+      CHECK(cmp.score == 0.0);
+    }
+
+    SECTION("compare: nested arrays of different lengths") {
+      const data_point short_row = touca::array().add(4).add(5);
+      const data_point long_row = touca::array().add(4).add(5).add(6);
+      const data_point full_row = touca::array().add(1).add(2).add(3);
+      const data_point left = touca::array().add(full_row).add(short_row);
+      const data_point right = touca::array().add(full_row).add(long_row);
+
+      // the second element is compared as a whole and, having grown by
+      // more than the size threshold, contributes nothing to the score.
+      const auto& cmp = compare(left, right);
+      CHECK(MatchType::None == cmp.match);
+      CHECK(cmp.score == 0.5);
+      CHECK(cmp.desc.size() == 1u);
+      CHECK(cmp.desc.count("[1]:array size shrunk by 1 elements"));
+    }
+
+    SECTION("compare: array of nested arrays of different lengths") {
+      touca::array left_rows;
+      touca::array right_rows;
+      for (auto i = 0; i < 6; i++) {
+        const data_point row = touca::array().add(i).add(i + 1);
+        if (i < 5) {
+          left_rows.add(row);
+        }
+        right_rows.add(row);
+      }
+      const data_point left = left_rows;
+      const data_point right = right_rows;
+
+      // the size threshold applies to the number of top-level elements,
+      // not to the number of their leaves.
+      const auto& cmp = compare(left, right);
+      CHECK(MatchType::None == cmp.match);
+      CHECK(cmp.score == Approx(5.0 / 6.0));
+      CHECK(cmp.desc.size() == 1u);
+      CHECK(cmp.desc.count("array size shrunk by 1 elements"));
+    }
+
+    SECTION("compare: mismatch nested value") {
+      const data_point row = touca::array().add(1).add(2).add(3);
+      const data_point changed = touca::array().add(1).add(2).add(4);
+      const data_point left = touca::array().add(row).add(row);
+      const data_point right = touca::array().add(row).add(changed);
+
+      const auto& cmp = compare(left, right);
+      CHECK(MatchType::None == cmp.match);
+      CHECK(cmp.score == Approx(5.0 / 6.0));
+      CHECK(cmp.desc.size() == 1u);
+      CHECK(cmp.desc.count("[1]:[2]:value is smaller by 1.000000"));
+    }
+
+    SECTION("serialize") {
+      const auto& value =
+          serializer<std::vector<float>>().serialize({1.1f, 1.2f, 1.3f});
+      const auto& buffer = serialize(value);
+      const auto& itype = deserialize(buffer);
+      const auto& cmp = compare(value, itype);
+
+      CHECK(internal_type::packed_array == itype.type());
+      CHECK(itype.to_string() == value.to_string());
+      CHECK(MatchType::Perfect == cmp.match);
+      CHECK(cmp.score == 1.0);
+      CHECK(cmp.desc.empty());
+    }
+  }
+
   SECTION("type: object") {
     SECTION("initialize: add number to object") {
       touca::object value("creature");
@@ -644,6 +915,80 @@ TEST_CASE("Simple Data Types") {
       CHECK(cmp.desc.empty());
     }
 
+    SECTION("copy and move") {
+      touca::object value("creature");
+      value.add("first_head", Head(2));
+      const auto expected =
+          R"({"creature":{"first_head":{"head":{"eyes":2}}}})";
+      data_point copied(value);
+      data_point moved(std::move(value));
+      CHECK(copied.to_string() == expected);
+      CHECK(moved.to_string() == expected);
+      copied = data_point::boolean(true);
+      CHECK(moved.to_string() == expected);
+      copied = moved;
+      moved = data_point::null();
+      CHECK(copied.to_string() == expected);
+    }
+
+    SECTION("compare: nested") {
+      const auto& make_heads = [](const std::vector<uint64_t>& eyes) {
+        std::vector<Head> heads;
+        for (const auto& v : eyes) {
+          heads.emplace_back(v);
+        }
+        return heads;
+      };
+      touca::object src("creature");
+      src.add("a", data_point(touca::object("x").add("b", 1).add("c", "s")))
+          .add("arr", std::vector<int>{1, 2})
+          .add("objs", make_heads({1, 2}))
+          .add("gone", true)
+          .add("scalar", 5);
+      touca::object dst("creature");
+      dst.add("a", data_point(touca::object("x")
+                                  .add("b", 2)
+                                  .add("c", "s")
+                                  .add("d", false)))
+          .add("arr", std::vector<int>{1, 3, 4})
+          .add("objs", make_heads({1}))
+          .add("fresh", 1.0)
+          .add("scalar", data_point(touca::array().add(1)));
+      const auto& cmp = compare(src, dst);
+
+      CHECK(MatchType::None == cmp.match);
+      CHECK(cmp.score == 0.25);
+      CHECK(cmp.desc == std::set<std::string>{
+                            "a.b: value is smaller by 1.000000",
+                            "a.d: new",
+                            "arr.[1]: value is smaller by 1.000000",
+                            "arr.[2]: new",
+                            "fresh: new",
+                            "gone: missing",
+                            "objs.[1]eyes: missing",
+                            "scalar: missing",
+                            "scalar.[0]: new",
+                        });
+    }
+
+    SECTION("compare: identical nested") {
+      const auto& make = [](const std::string& name) {
+        touca::object out(name);
+        out.add("a", data_point(touca::object("x").add("b", 1).add("c", "s")))
+            .add("arr", std::vector<int>{1, 2})
+            .add("objs", std::vector<Head>{Head(1), Head(2)});
+        return data_point(out);
+      };
+      const auto& src = make("creature");
+      const auto& dst = make("monster");
+      const auto& cmp = compare(src, dst);
+
+      CHECK(src.fingerprint() == dst.fingerprint());
+      CHECK(MatchType::Perfect == cmp.match);
+      CHECK(cmp.score == 1.0);
+      CHECK(cmp.desc.empty());
+    }
+
     SECTION("initialize: array of objects") {
       using type_t = std::vector<Head>;
       const auto& make = [](const std::vector<int>& vec) {